@@ -1,46 +1,189 @@
 #pragma once
 
+#include "SearchLayouts.hpp"
+#include "SortKeys.hpp"
+
 #include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+// Non-owning binary search over sorted contiguous elements. Layout selects
+// how the sorted keys are laid out for the search (see SearchLayouts.hpp);
+// rank() returns the index in the sorted elements either way. The view
+// holds a span and its layout, so queries do no reference counting and any
+// number of threads can query one view; the elements must outlive it and
+// not change meanwhile.
+template <typename V, template <typename> class Layout = SearchLayout::Sorted>
+class BinarySearchView {
+public:
+  explicit BinarySearchView(std::span<const V> aSorted) : fSorted(aSorted), fLayout(aSorted) {
+  }
+
+  int rank(const V& aSearch) const {
+    return fLayout.rank(fSorted, aSearch);
+  }
+
+  // rank() of every query into aOut (at least as long as aQueries), with the
+  // searches of a group of queries interleaved so their misses overlap
+  void rankBatch(std::span<const V> aQueries, std::span<int> aOut) const {
+    if (aOut.size() < aQueries.size()) {
+      throw std::invalid_argument("Output shorter than the queries");
+    }
+    fLayout.rankBatch(fSorted, aQueries, aOut);
+  }
+
+  std::span<const V> sorted() const {
+    return fSorted;
+  }
+
+private:
+  std::span<const V> fSorted;
+  Layout<V> fLayout;
+};
+
+// Owning binary search: a sorted copy of the keys and a view over it. The
+// index lives as long as its owner keeps it (it moves but does not copy),
+// independent of the container it was built from.
+template <typename V, template <typename> class Layout = SearchLayout::Sorted>
+class BinarySearchIndex {
+public:
+  template <std::ranges::input_range R>
+  explicit BinarySearchIndex(const R& aKeys) : fSorted(sortedCopy(aKeys)), fView(fSorted) {
+  }
+
+  BinarySearchIndex(const BinarySearchIndex&) = delete;
+  BinarySearchIndex& operator=(const BinarySearchIndex&) = delete;
+  // The view's span follows the moved buffer
+  BinarySearchIndex(BinarySearchIndex&&) = default;
+  BinarySearchIndex& operator=(BinarySearchIndex&&) = default;
+
+  int rank(const V& aSearch) const {
+    return fView.rank(aSearch);
+  }
+
+  void rankBatch(std::span<const V> aQueries, std::span<int> aOut) const {
+    fView.rankBatch(aQueries, aOut);
+  }
+
+  const BinarySearchView<V, Layout>& view() const {
+    return fView;
+  }
+
+private:
+  template <typename R>
+  static std::vector<V> sortedCopy(const R& aKeys) {
+    std::vector<V> sorted(std::ranges::begin(aKeys), std::ranges::end(aKeys));
+    SortKeys::sort(sorted);
+    return sorted;
+  }
+
+  std::vector<V> fSorted;
+  BinarySearchView<V, Layout> fView;
+};
 
-template <typename T>
+// How BinarySearch orders the shared container's keys
+enum class SortMode {
+  IN_PLACE,   // Sort the container itself; rank() is an index in it
+  COPY,       // Sort a private copy; rank() is an index in sorted order
+  PERMUTATION // Sort a permutation of indices; rank() is an index in the
+              // unchanged container
+};
+
+// Binary search over a shared container. Construction sorts it (see
+// SortMode) with SortKeys::sort, which skips keys already in order and sorts
+// large inputs in parallel or by radix. Every query locks the weak
+// reference; prefer a view or an index when several threads query at once.
+template <typename T, template <typename> class Layout = SearchLayout::Sorted>
 class BinarySearch {
 public:
-  BinarySearch(std::shared_ptr<T> aData) : fData(aData) {
-    if (fData.expired()) {
+  using value_type = std::ranges::range_value_t<T>;
+
+  BinarySearch(std::shared_ptr<T> aData, SortMode aMode = SortMode::IN_PLACE)
+      : fData(aData), fMode(aMode), fLayout(buildLayout(aData)) {
+  }
+
+  int rank(const value_type& aSearch);
+
+  // rank() of every query into aOut (at least as long as aQueries), with the
+  // searches of a group of queries interleaved so their misses overlap
+  void rankBatch(std::span<const value_type> aQueries, std::span<int> aOut);
+
+private:
+  // The container's keys in sorted order, through the permutation
+  static auto permuted(const T& aData, const std::vector<uint32_t>& aPermutation) {
+    auto begin = std::ranges::begin(aData);
+    return aPermutation | std::views::transform([begin](uint32_t aIndex) -> decltype(auto) {
+             return begin[aIndex];
+           });
+  }
+
+  // Sorts according to fMode and builds the layout over the sorted keys
+  Layout<value_type> buildLayout(const std::shared_ptr<T>& aData) {
+    if (!aData) {
       throw std::logic_error("Cannot bind to an expired container");
     }
 
-    auto data = fData.lock();
+    switch (fMode) {
+      case SortMode::COPY:
+        fSorted = SortKeys::sortedCopy(*aData);
+        return Layout<value_type>(fSorted);
+      case SortMode::PERMUTATION:
+        fPermutation = SortKeys::sortedPermutation(*aData);
+        return Layout<value_type>(permuted(*aData, fPermutation));
+      case SortMode::IN_PLACE:
+        break;
+    }
     // Ensure the data is sorted
-    std::ranges::sort(*data);
+    SortKeys::sort(*aData);
+    return Layout<value_type>(*aData);
   }
 
-  int rank(const typename T::value_type& aSearch);
-
-private:
   std::weak_ptr<T> fData;
+  SortMode fMode;
+  std::vector<value_type> fSorted;     // COPY
+  std::vector<uint32_t> fPermutation;  // PERMUTATION
+  Layout<value_type> fLayout;
 };
 
-template <typename T>
-int BinarySearch<T>::rank(const typename T::value_type& aSearch) {
-  if (fData.expired()) {
+template <typename T, template <typename> class Layout>
+int BinarySearch<T, Layout>::rank(const value_type& aSearch) {
+  if (fMode == SortMode::COPY) {
+    return fLayout.rank(fSorted, aSearch);
+  }
+  auto data = fData.lock();
+  if (!data) {
     throw std::logic_error("Operation on unbound container");
   }
+  if (fMode == SortMode::PERMUTATION) {
+    int rank = fLayout.rank(permuted(*data, fPermutation), aSearch);
+    return rank < 0 ? rank : static_cast<int>(fPermutation[rank]);
+  }
+  return fLayout.rank(*data, aSearch);
+}
+
+template <typename T, template <typename> class Layout>
+void BinarySearch<T, Layout>::rankBatch(std::span<const value_type> aQueries, std::span<int> aOut) {
+  if (aOut.size() < aQueries.size()) {
+    throw std::invalid_argument("Output shorter than the queries");
+  }
+  if (fMode == SortMode::COPY) {
+    fLayout.rankBatch(fSorted, aQueries, aOut);
+    return;
+  }
   auto data = fData.lock();
-  int low = 0;
-  int high = data->size() - 1;
-
-  while (low <= high) {
-    int mid = low + (high - low) / 2;
-    if ((*data)[mid] < aSearch) {
-      low = mid + 1;
-    } else if ((*data)[mid] > aSearch) {
-      high = mid - 1;
-    } else {
-      return mid; // Found
+  if (!data) {
+    throw std::logic_error("Operation on unbound container");
+  }
+  if (fMode == SortMode::PERMUTATION) {
+    fLayout.rankBatch(permuted(*data, fPermutation), aQueries, aOut);
+    for (size_t i = 0; i != aQueries.size(); ++i) {
+      aOut[i] = aOut[i] < 0 ? aOut[i] : static_cast<int>(fPermutation[aOut[i]]);
     }
+    return;
   }
-
-  return -1; // Not found
+  fLayout.rankBatch(*data, aQueries, aOut);
 }
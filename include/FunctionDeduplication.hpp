@@ -0,0 +1,113 @@
+#pragma once
+
+#include "LLVMValueNumbering.hpp"
+
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Transforms/Utils/FunctionComparator.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Identical-function detection built on LLVMValueNumbering.
+//
+// Every defined function gets a fingerprint from its ordered value-number
+// sequence, with arguments numbered by position only, so structurally
+// identical functions get equal fingerprints. Fingerprints are computed in
+// parallel and functions are bucketed by them; the exact (and expensive)
+// llvm::FunctionComparator only runs inside a bucket. This replaces the
+// quadratic pairwise comparison with near-linear work.
+namespace FunctionDeduplication {
+  using Group = std::vector<llvm::Function*>;
+
+  // aVN is cleared first: the pessimistic numbering hands out sequential
+  // numbers for cycles and blocks, which only line up between functions
+  // numbered from the same starting state.
+  inline uint64_t fingerprint(llvm::Function& aFunction,
+                              LLVMValueNumbering& aVN) {
+    aVN.clear();
+    aVN.setPositionalArguments(true);
+    llvm::hash_code hash =
+        llvm::hash_combine(aFunction.getFunctionType(), aFunction.size());
+    for (auto& bb : aFunction) {
+      hash = llvm::hash_combine(hash, bb.size());
+      for (auto& inst : bb) {
+        hash = llvm::hash_combine(hash, aVN.getValueNumber(&inst));
+      }
+    }
+    return static_cast<uint64_t>(hash);
+  }
+
+  // Split one bucket into groups of functions that FunctionComparator finds
+  // equal. Each group is compared against its first member only.
+  inline std::vector<Group> splitBucket(const Group& aBucket) {
+    llvm::GlobalNumberState globalNumbers;
+    std::vector<Group> groups;
+    for (auto* function : aBucket) {
+      bool placed = false;
+      for (auto& group : groups) {
+        llvm::FunctionComparator comparator(group.front(), function,
+                                            &globalNumbers);
+        if (comparator.compare() == 0) {
+          group.push_back(function);
+          placed = true;
+          break;
+        }
+      }
+      if (!placed) {
+        groups.push_back({function});
+      }
+    }
+    return groups;
+  }
+
+  // Groups of two or more identical function definitions, in module order.
+  // The module is only read, so numbering and bucket comparison can both run
+  // on the TBB pool.
+  inline std::vector<Group> findDuplicates(llvm::Module& aModule) {
+    std::vector<llvm::Function*> functions;
+    for (auto& function : aModule) {
+      if (!function.isDeclaration()) {
+        functions.push_back(&function);
+      }
+    }
+
+    std::vector<uint64_t> fingerprints(functions.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, functions.size()),
+                      [&](const tbb::blocked_range<size_t>& aRange) {
+                        LLVMValueNumbering vn;
+                        for (size_t i = aRange.begin(); i != aRange.end(); ++i) {
+                          fingerprints[i] = fingerprint(*functions[i], vn);
+                        }
+                      });
+
+    std::unordered_map<uint64_t, size_t> bucketOf;
+    std::vector<Group> buckets;
+    for (size_t i = 0; i != functions.size(); ++i) {
+      auto [it, inserted] = bucketOf.try_emplace(fingerprints[i], buckets.size());
+      if (inserted) {
+        buckets.emplace_back();
+      }
+      buckets[it->second].push_back(functions[i]);
+    }
+
+    std::vector<std::vector<Group>> split(buckets.size());
+    tbb::parallel_for(size_t(0), buckets.size(), [&](size_t aIndex) {
+      if (buckets[aIndex].size() > 1) {
+        split[aIndex] = splitBucket(buckets[aIndex]);
+      }
+    });
+
+    std::vector<Group> duplicates;
+    for (auto& groups : split) {
+      for (auto& group : groups) {
+        if (group.size() > 1) {
+          duplicates.push_back(std::move(group));
+        }
+      }
+    }
+    return duplicates;
+  }
+} // namespace FunctionDeduplication
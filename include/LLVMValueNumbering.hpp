@@ -1,36 +1,129 @@
 #pragma once
 
+#include "VNExpressionKey.hpp"
+#include "VNStats.hpp"
 #include "VNTable.hpp"
 #include <llvm/IR/Value.h>
 #include <llvm/IR/Instruction.h>
 #include <llvm/IR/Constants.h>
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Analysis/MemorySSA.h>
 #include <llvm/ADT/Hashing.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/DenseMapInfo.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/ScopedHashTable.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/ValueHandle.h>
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 class LLVMValueNumbering {
 public:
     using ExprValueTable = VNTable<llvm::Value*>;
     using ValueNumber = ExprValueTable::ValueNumber;
+    using LeaderTable = llvm::ScopedHashTable<ValueNumber, llvm::Instruction*>;
+
+    // How cycles in the operand graph (loop-carried PHIs) are numbered.
+    // Pessimistic breaks a cycle with a fresh temporary VN. Optimistic finds the
+    // strongly connected components of the operand graph (Tarjan) and iterates
+    // each cyclic one to a fixpoint, starting from the assumption that its
+    // members are congruent; acyclic code is still numbered in a single pass.
+    enum class CycleMode { Pessimistic, Optimistic };
+
+    explicit LLVMValueNumbering(CycleMode mode = CycleMode::Pessimistic) : fMode(mode) {
+    }
+
+    // Mutation handles point back at this object
+    LLVMValueNumbering(const LLVMValueNumbering&) = delete;
+    LLVMValueNumbering& operator=(const LLVMValueNumbering&) = delete;
 
 private:
+    // Observes one numbered value. Deleting the value drops its entry (and this
+    // handle); replacing all its uses invalidates the users that were numbered
+    // from it.
+    class MutationHandle final : public llvm::CallbackVH {
+    public:
+        MutationHandle(llvm::Value* value, LLVMValueNumbering* owner)
+            : llvm::CallbackVH(value), fOwner(owner) {
+        }
+
+        void deleted() override {
+            fOwner->forget(getValPtr()); // Destroys this handle
+        }
+
+        void allUsesReplacedWith(llvm::Value* /*newValue*/) override {
+            fOwner->invalidateUsers(getValPtr());
+        }
+
+    private:
+        LLVMValueNumbering* fOwner;
+    };
+
+    // Provisional value number of an SCC member during optimistic iteration:
+    // either a final VN from outside the SCC or a class local to it. Local
+    // class 0 is "not known yet" (optimistic top).
+    struct ProvisionalVN {
+        bool local = true;
+        ValueNumber value = 0;
+
+        bool isTop() const {
+            return local && value == 0;
+        }
+        bool operator==(const ProvisionalVN& other) const {
+            return local == other.local && value == other.value;
+        }
+        bool operator!=(const ProvisionalVN& other) const {
+            return !(*this == other);
+        }
+        llvm::hash_code hash() const {
+            return llvm::hash_combine(local, value);
+        }
+    };
+
+    CycleMode fMode;
+    llvm::DenseMap<const llvm::BasicBlock*, unsigned> fBlockOrder; // Program order of blocks, for canonical SCC order
     ExprValueTable fTable;
+    llvm::MemorySSA* fMemorySSA = nullptr; // Memory versions of the function being numbered, if any
     ValueNumber fNextVN = 1;
     mutable std::unordered_set<llvm::Value*> fComputingStack; // Track values currently being computed
+    LeaderTable fLeaders; // Available leaders, only populated during a dominator-scoped walk
+    bool fPositionalArguments = false;
+    bool fTrackMutations = false;
+    llvm::DenseMap<llvm::Value*, std::unique_ptr<MutationHandle>> fHandles; // One per numbered value when tracking
+    llvm::SmallPtrSet<llvm::Value*, 16> fInvalidated; // Live values whose entry was dropped by a mutation
+    MW_VN_STAT(VNStats::Stats fStats;) // Only with -DMW_VN_STATS=1; survives clear()
 
 public:
     // Get or compute value number for an LLVM expression
     ValueNumber getValueNumber(llvm::Value* expr) {
         auto existing = fTable.value(expr);
         if (existing) {
+            MW_VN_STAT(fStats.hit());
             return *existing;
         }
+        MW_VN_STAT(fStats.miss());
+
+        if (fMode == CycleMode::Optimistic) {
+            if (auto* inst = llvm::dyn_cast<llvm::Instruction>(expr)) {
+                numberComponentsFrom(inst);
+                return *fTable.value(expr);
+            }
+        }
 
         // Check for recursion - if we're already computing this value, assign a temporary VN
         if (fComputingStack.find(expr) != fComputingStack.end()) {
             // Return a temporary value number to break recursion
             ValueNumber tempVN = fNextVN++;
-            fTable.insertOrReplace(expr, tempVN);
+            MW_VN_STAT(fStats.cycleBreak());
+            record(expr, tempVN);
             return tempVN;
         }
 
@@ -39,7 +132,7 @@ public:
         
         // Compute new value number
         ValueNumber vn = computeExpressionValueNumber(expr);
-        fTable.insertOrReplace(expr, vn);
+        record(expr, vn);
         
         // Remove from computing stack
         fComputingStack.erase(expr);
@@ -47,18 +140,410 @@ public:
         return vn;
     }
 
+    // Seed the table with a number computed elsewhere, e.g. reloaded from a cache
+    void restoreValueNumber(llvm::Value* expr, ValueNumber vn) {
+        record(expr, vn);
+    }
+
+    CycleMode cycleMode() const {
+        return fMode;
+    }
+
+    bool positionalArguments() const {
+        return fPositionalArguments;
+    }
+
+    bool usesMemorySSA() const {
+        return fMemorySSA != nullptr;
+    }
+
+#if MW_VN_STATS
+    // Counters and trace of everything numbered since the last stats().reset()
+    VNStats::Stats& stats() {
+        return fStats;
+    }
+#endif
+
     // Get all expressions with the same value number (congruence class)
     auto getCongruenceClass(ValueNumber vn) const {
         return fTable.congruence(vn);
     }
 
+    // Dominator-scoped mode: visit every instruction in dominator-tree preorder,
+    // with one leader scope per basic block. Inside the visitor,
+    // availableLeader() answers "is a value with this number available here?"
+    // with a single lookup, and publishLeader() makes an instruction available
+    // to everything it dominates. Leaving a block pops its scope, which rolls
+    // back exactly the leaders that block published.
+    template <typename Visitor>
+    void forEachInDominatorScope(const llvm::DominatorTree& domTree, Visitor visit) {
+        struct ScopeFrame {
+            const llvm::DomTreeNode* node;
+            llvm::DomTreeNode::const_iterator nextChild;
+            std::unique_ptr<LeaderTable::ScopeTy> scope;
+        };
+
+        // Explicit stack: dominator trees of large functions are too deep to recurse
+        std::vector<ScopeFrame> stack;
+        auto enter = [&](const llvm::DomTreeNode* node) {
+            stack.push_back({node, node->begin(), std::make_unique<LeaderTable::ScopeTy>(fLeaders)});
+            for (auto& inst : *node->getBlock()) {
+                visit(inst);
+            }
+        };
+
+        enter(domTree.getRootNode());
+        while (!stack.empty()) {
+            auto& frame = stack.back();
+            if (frame.nextChild == frame.node->end()) {
+                stack.pop_back(); // Destroying the scope rolls back its leaders
+                continue;
+            }
+            enter(*frame.nextChild++);
+        }
+    }
+
+    // Leader for vn in the current dominator scope, or nullptr if none is available
+    llvm::Instruction* availableLeader(ValueNumber vn) const {
+        return fLeaders.lookup(vn);
+    }
+
+    // Make inst the leader for vn in the current block and the blocks it dominates
+    void publishLeader(ValueNumber vn, llvm::Instruction* inst) {
+        fLeaders.insert(vn, inst);
+    }
+
+    // Number memory reads by the memory version they observe. With MemorySSA, a
+    // simple load or read-only call is keyed by its operands plus its clobbering
+    // MemoryAccess, so two loads of one address are congruent exactly when no
+    // clobber intervenes; every other memory-touching instruction is distinct.
+    // MemorySSA is per function: set it before numbering each function, or pass
+    // nullptr to hash memory instructions like any other.
+    void setMemorySSA(llvm::MemorySSA* mssa) {
+        fMemorySSA = mssa;
+    }
+
+    // Number arguments by position only instead of by (function, position), so
+    // that structurally identical functions get identical value numbers
+    void setPositionalArguments(bool positional) {
+        fPositionalArguments = positional;
+    }
+
+    // Keep the table in sync with IR mutations instead of renumbering from
+    // scratch. Every numbered value is then observed through a CallbackVH:
+    // erasing it removes its entry, and replacing all its uses (RAUW) drops the
+    // entries of its transitive users, which renumberInvalidated() or the next
+    // getValueNumber() recomputes. Changes that bypass RAUW (setOperand,
+    // removed stores under MemorySSA) must be reported with invalidate().
+    // The result equals a fresh numbering in optimistic mode and for acyclic
+    // code; in pessimistic mode the temporary numbers that break a cycle
+    // depend on visit order, so a renumbered loop may be partitioned
+    // differently. Switching tracking on or off clears the table.
+    void trackMutations(bool track) {
+        clear();
+        fTrackMutations = track;
+    }
+
+    // Drop the entries of value and of everything numbered from it
+    void invalidate(llvm::Value* value) {
+        if (fTable.value(value)) {
+            fTable.erase(value);
+            fInvalidated.insert(value);
+        }
+        invalidateUsers(value);
+    }
+
+    // Recompute the entries dropped by mutations; returns how many were renumbered
+    size_t renumberInvalidated() {
+        llvm::SmallVector<llvm::Value*, 16> pending(fInvalidated.begin(), fInvalidated.end());
+        fInvalidated.clear();
+        for (auto* value : pending) {
+            getValueNumber(value);
+        }
+        return pending.size();
+    }
+
     // Clear all mappings
     void clear() {
         fTable.clear();
+        fHandles.clear();
+        fInvalidated.clear();
+        fBlockOrder.clear();
         fNextVN = 1;
     }
 
 private:
+    void record(llvm::Value* value, ValueNumber vn) {
+        MW_VN_STAT(countCollision(value, vn));
+        fTable.insertOrReplace(value, vn);
+        if (fTrackMutations && !fHandles.count(value)) {
+            fHandles[value] = std::make_unique<MutationHandle>(value, this);
+        }
+    }
+
+#if MW_VN_STATS
+    // vn is about to be given to value: a collision if vn's class already
+    // holds a different operation. PHIs are skipped, as optimistic numbering
+    // legitimately makes a PHI congruent to the value it copies.
+    void countCollision(llvm::Value* value, ValueNumber vn) {
+        auto* inst = llvm::dyn_cast<llvm::Instruction>(value);
+        auto [member, end] = fTable.congruence(vn);
+        if (!inst || llvm::isa<llvm::PHINode>(inst) || member == end) {
+            return;
+        }
+        auto* other = llvm::dyn_cast<llvm::Instruction>(member->second);
+        if (other && other != inst && !llvm::isa<llvm::PHINode>(other) && !inst->isSameOperationAs(other)) {
+            fStats.collision();
+        }
+    }
+#endif
+
+    // The value is being deleted: nothing may keep pointing at it
+    void forget(llvm::Value* value) {
+        fTable.erase(value);
+        fInvalidated.erase(value);
+        fHandles.erase(value);
+    }
+
+    // Users are still attached when a RAUW is reported, so the numbered part of
+    // the def-use closure can be walked. Values without an entry stop the walk:
+    // nothing numbered can depend on them.
+    void invalidateUsers(llvm::Value* value) {
+        fBlockOrder.clear();
+        llvm::SmallVector<llvm::Value*, 16> worklist(value->user_begin(), value->user_end());
+        while (!worklist.empty()) {
+            auto* user = worklist.pop_back_val();
+            if (!fTable.value(user)) {
+                continue;
+            }
+            fTable.erase(user);
+            fInvalidated.insert(user);
+            worklist.append(user->user_begin(), user->user_end());
+        }
+    }
+
+    // Iterative Tarjan over the not yet numbered instructions reachable through
+    // operands. Components complete operands-first, so each one only sees
+    // external operands that are already numbered.
+    void numberComponentsFrom(llvm::Instruction* root) {
+        struct Frame {
+            llvm::Instruction* inst;
+            unsigned nextOperand;
+        };
+        llvm::DenseMap<llvm::Instruction*, unsigned> index;
+        llvm::DenseMap<llvm::Instruction*, unsigned> lowLink;
+        llvm::SmallPtrSet<llvm::Instruction*, 16> onStack;
+        std::vector<llvm::Instruction*> componentStack;
+        std::vector<Frame> callStack;
+
+        auto visit = [&](llvm::Instruction* inst) {
+            unsigned next = index.size();
+            index[inst] = next;
+            lowLink[inst] = next;
+            componentStack.push_back(inst);
+            onStack.insert(inst);
+            callStack.push_back({inst, 0});
+            MW_VN_STAT(fStats.depth(callStack.size()));
+        };
+
+        visit(root);
+        while (!callStack.empty()) {
+            auto* inst = callStack.back().inst;
+            unsigned operandNo = callStack.back().nextOperand++;
+            if (operandNo < inst->getNumOperands()) {
+                auto* operand = llvm::dyn_cast<llvm::Instruction>(inst->getOperand(operandNo));
+                if (!operand || fTable.value(operand)) {
+                    continue;
+                }
+                if (!index.count(operand)) {
+                    visit(operand);
+                } else if (onStack.count(operand)) {
+                    lowLink[inst] = std::min(lowLink[inst], index[operand]);
+                }
+                continue;
+            }
+
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                auto* parent = callStack.back().inst;
+                lowLink[parent] = std::min(lowLink[parent], lowLink[inst]);
+            }
+            if (lowLink[inst] != index[inst]) {
+                continue;
+            }
+
+            std::vector<llvm::Instruction*> component;
+            llvm::Instruction* member = nullptr;
+            do {
+                member = componentStack.back();
+                componentStack.pop_back();
+                onStack.erase(member);
+                component.push_back(member);
+            } while (member != inst);
+            numberComponent(component);
+        }
+    }
+
+    void numberComponent(std::vector<llvm::Instruction*>& members) {
+        auto* first = members.front();
+        bool selfCycle = llvm::any_of(first->operand_values(), [&](llvm::Value* operand) {
+            return operand == first;
+        });
+        if (members.size() == 1 && !selfCycle) {
+            record(first, computeInstructionVN(first));
+            return;
+        }
+        numberCyclicComponent(members);
+    }
+
+    // Optimistic fixpoint over one cyclic SCC. A local class is identified by
+    // the position of its first member in program order, so class ids are stable
+    // between rounds and independent of which member was requested first.
+    void numberCyclicComponent(std::vector<llvm::Instruction*>& members) {
+        sortInProgramOrder(members);
+        llvm::DenseMap<llvm::Value*, unsigned> position;
+        for (unsigned i = 0; i != members.size(); ++i) {
+            position[members[i]] = i;
+        }
+
+        std::vector<ProvisionalVN> current(members.size());
+        std::vector<llvm::hash_code> keys(members.size());
+        auto operandVN = [&](llvm::Value* operand) -> ProvisionalVN {
+            auto it = position.find(operand);
+            if (it != position.end()) {
+                return current[it->second];
+            }
+            return {false, getValueNumber(operand)};
+        };
+
+        bool changed = true;
+        for (unsigned round = 0; changed && round != members.size() + 2; ++round) {
+            changed = false;
+            std::unordered_map<size_t, ValueNumber> classes;
+            for (unsigned i = 0; i != members.size(); ++i) {
+                ProvisionalVN next;
+                if (auto copy = phiCopy(members[i], operandVN)) {
+                    next = *copy;
+                    keys[i] = copy->hash();
+                } else {
+                    keys[i] = memberKey(members[i], operandVN);
+                    next.value = classes.try_emplace(keys[i], i + 1).first->second;
+                }
+                changed |= next != current[i];
+                current[i] = next;
+            }
+        }
+
+        // No fixpoint within the round budget: keep every member in its own class
+        if (changed) {
+            for (unsigned i = 0; i != members.size(); ++i) {
+                current[i] = {true, i + 1};
+            }
+            for (unsigned i = 0; i != members.size(); ++i) {
+                keys[i] = memberKey(members[i], operandVN);
+            }
+        }
+
+        // Local classes are only meaningful within this SCC. Qualifying them with a
+        // fingerprint of the whole SCC keeps them apart from other SCCs, while
+        // isomorphic SCCs (e.g. two identical induction variables) stay congruent.
+        llvm::hash_code fingerprint = llvm::hash_combine_range(keys.begin(), keys.end());
+        for (unsigned i = 0; i != members.size(); ++i) {
+            ValueNumber vn = current[i].local
+                ? static_cast<ValueNumber>(llvm::hash_combine(fingerprint, current[i].value))
+                : current[i].value;
+            record(members[i], vn);
+        }
+    }
+
+    // A PHI whose known incoming values all agree is optimistically a copy of
+    // that value. Unknown (top) incoming values and the PHI itself are ignored.
+    template <typename OperandVN>
+    std::optional<ProvisionalVN> phiCopy(llvm::Instruction* inst, OperandVN& operandVN) {
+        auto* phi = llvm::dyn_cast<llvm::PHINode>(inst);
+        if (!phi) {
+            return {};
+        }
+        std::optional<ProvisionalVN> agreed;
+        for (llvm::Value* incoming : phi->incoming_values()) {
+            if (incoming == phi) {
+                continue;
+            }
+            ProvisionalVN vn = operandVN(incoming);
+            if (vn.isTop()) {
+                continue;
+            }
+            if (agreed && *agreed != vn) {
+                return {};
+            }
+            agreed = vn;
+        }
+        return agreed;
+    }
+
+    // Expression key of an SCC member under the current provisional numbering.
+    // PHIs are qualified by their block: equal incoming values in different
+    // blocks do not make equal PHIs.
+    template <typename OperandVN>
+    llvm::hash_code memberKey(llvm::Instruction* inst, OperandVN& operandVN) {
+        std::vector<size_t> operands;
+        for (auto* operand : inst->operand_values()) {
+            operands.push_back(operandVN(operand).hash());
+        }
+        if (llvm::isa<llvm::BinaryOperator>(inst) && inst->isCommutative() && operands[0] > operands[1]) {
+            std::swap(operands[0], operands[1]);
+        }
+        const llvm::BasicBlock* block = llvm::isa<llvm::PHINode>(inst) ? inst->getParent() : nullptr;
+        return llvm::hash_combine(headerWord(inst), block, memoryStateKey(inst),
+                                  llvm::hash_combine_range(operands.begin(), operands.end()));
+    }
+
+    // What sets an instruction apart besides its operands: opcode, result type
+    // and predicate, so that e.g. `icmp eq` and `icmp ne`, or `zext` to i32 and
+    // to i64, of the same operands differ. Both memberKey() and
+    // computeInstructionVN() start from it.
+    static uint64_t headerWord(const llvm::Instruction* inst) {
+        unsigned predicate = 0;
+        if (auto* cmp = llvm::dyn_cast<llvm::CmpInst>(inst)) {
+            predicate = cmp->getPredicate();
+        }
+        return VNExpressionKey::header(inst->getOpcode(), reinterpret_cast<uintptr_t>(inst->getType()), predicate);
+    }
+
+    // Memory state an instruction's result depends on. Loads and read-only
+    // calls depend on their clobbering access; writes, volatile and atomic
+    // accesses are keyed by themselves so they are never congruent to anything.
+    llvm::hash_code memoryStateKey(llvm::Instruction* inst) const {
+        if (!fMemorySSA || !inst->mayReadOrWriteMemory()) {
+            return llvm::hash_value(0);
+        }
+        auto* load = llvm::dyn_cast<llvm::LoadInst>(inst);
+        auto* call = llvm::dyn_cast<llvm::CallBase>(inst);
+        bool readsOnly = (load && load->isSimple()) || (call && call->onlyReadsMemory());
+        if (!readsOnly) {
+            return llvm::hash_value(inst);
+        }
+        return llvm::hash_value(fMemorySSA->getWalker()->getClobberingMemoryAccess(inst));
+    }
+
+    void sortInProgramOrder(std::vector<llvm::Instruction*>& insts) {
+        auto blockOrder = [&](const llvm::BasicBlock* bb) {
+            if (!fBlockOrder.count(bb)) {
+                unsigned next = 0;
+                for (auto& block : *bb->getParent()) {
+                    fBlockOrder[&block] = next++;
+                }
+            }
+            return fBlockOrder.lookup(bb);
+        };
+        std::sort(insts.begin(), insts.end(), [&](llvm::Instruction* lhs, llvm::Instruction* rhs) {
+            if (lhs->getParent() != rhs->getParent()) {
+                return blockOrder(lhs->getParent()) < blockOrder(rhs->getParent());
+            }
+            return lhs->comesBefore(rhs);
+        });
+    }
+
     ValueNumber computeExpressionValueNumber(llvm::Value* expr) {
         // Handle different types of LLVM values
         
@@ -85,31 +570,34 @@ private:
     }
 
     ValueNumber computeInstructionVN(llvm::Instruction* inst) {
-        // Compute hash based on opcode and operand value numbers
-        llvm::hash_code hash = llvm::hash_value(inst->getOpcode());
-        
-        // Include operand value numbers in hash
+        MW_VN_STAT(VNStats::Scope statsScope(fStats, inst->getOpcode()));
+
+        // Flat key: header word, operand value numbers (each looked up once),
+        // then the memory state, hashed in a single pass
+        VNExpressionKey::Words key;
+        key.push_back(headerWord(inst));
         for (auto& operand : inst->operands()) {
-            ValueNumber operandVN = getValueNumber(operand.get());
-            hash = llvm::hash_combine(hash, operandVN);
+            key.push_back(getValueNumber(operand.get()));
         }
-        
-        // Also consider instruction attributes for precise matching
-        if (auto* binOp = llvm::dyn_cast<llvm::BinaryOperator>(inst)) {
-            // Include commutativity for binary operations
-            if (binOp->isCommutative()) {
-                // Ensure commutative operations get same hash regardless of operand order
-                ValueNumber op1VN = getValueNumber(inst->getOperand(0));
-                ValueNumber op2VN = getValueNumber(inst->getOperand(1));
-                if (op1VN > op2VN) std::swap(op1VN, op2VN);
-                hash = llvm::hash_combine(llvm::hash_value(inst->getOpcode()), op1VN, op2VN);
-            }
+
+        // Commutative operations get the same key regardless of operand order
+        if (llvm::isa<llvm::BinaryOperator>(inst) && inst->isCommutative()) {
+            VNExpressionKey::sortPair(key[1], key[2]);
         }
-        
-        return static_cast<ValueNumber>(hash);
+
+        // Memory reads are only congruent if they observe the same memory version
+        if (fMemorySSA) {
+            key.push_back(memoryStateKey(inst));
+        }
+
+        return VNExpressionKey::hash(key);
     }
 
     ValueNumber computeArgumentVN(llvm::Argument* arg) {
+        if (fPositionalArguments) {
+            return static_cast<ValueNumber>(llvm::hash_combine(arg->getArgNo()));
+        }
+
         // Arguments get unique value numbers based on their position
         // and parent function
         llvm::hash_code hash = llvm::hash_combine(
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "SortKeys.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+// Updatable sorted multiset of keys, log-structured.
+//
+// Writes go to a small sorted buffer. A full buffer becomes a sorted run, and
+// runs of similar size are merged, so each key is merged O(log n) times and
+// an update costs amortized O(log n) instead of re-sorting the whole array.
+// Erasing a key that is not in the buffer records a tombstone; merges cancel
+// tombstones against the keys they delete.
+//
+// Queries answer in terms of positions in the sorted sequence of live keys,
+// like std::lower_bound on a sorted array would: lowerBound(x) is the number
+// of keys less than x. Each query binary searches the buffer and every run
+// (O(log^2 n)); there are O(log n) runs.
+template <typename V>
+class LSMIndex {
+public:
+  // Pending writes before the buffer becomes a run: large enough to amortize
+  // the merges, small enough for the sorted insertion to stay in L1/L2
+  static constexpr size_t BUFFER_CAPACITY = 1024;
+
+  LSMIndex() = default;
+
+  // Bulk-loads aKeys as one run
+  template <typename Range>
+  explicit LSMIndex(const Range& aKeys) {
+    Run run;
+    run.keys.assign(std::ranges::begin(aKeys), std::ranges::end(aKeys));
+    SortKeys::sort(run.keys);
+    if (!run.keys.empty()) {
+      fSize = run.keys.size();
+      fRuns.push_back(std::move(run));
+    }
+  }
+
+  void insert(const V& aKey) {
+    fBuffer.keys.insert(std::ranges::upper_bound(fBuffer.keys, aKey), aKey);
+    ++fSize;
+    flushIfFull();
+  }
+
+  // Removes one occurrence of aKey; false if there is none
+  bool erase(const V& aKey) {
+    auto [first, last] = std::ranges::equal_range(fBuffer.keys, aKey);
+    if (first != last) {
+      fBuffer.keys.erase(first);
+    } else if (count(aKey) != 0) {
+      fBuffer.tombstones.insert(std::ranges::upper_bound(fBuffer.tombstones, aKey), aKey);
+      flushIfFull();
+    } else {
+      return false;
+    }
+    --fSize;
+    return true;
+  }
+
+  // Number of keys less than aKey
+  size_t lowerBound(const V& aKey) const {
+    return position(aKey, [](const std::vector<V>& aRun, const V& aKey) {
+      return std::ranges::lower_bound(aRun, aKey) - aRun.begin();
+    });
+  }
+
+  // Number of keys not greater than aKey
+  size_t upperBound(const V& aKey) const {
+    return position(aKey, [](const std::vector<V>& aRun, const V& aKey) {
+      return std::ranges::upper_bound(aRun, aKey) - aRun.begin();
+    });
+  }
+
+  // Positions [first, last) of the keys equal to aKey
+  std::pair<size_t, size_t> equalRange(const V& aKey) const {
+    return {lowerBound(aKey), upperBound(aKey)};
+  }
+
+  size_t count(const V& aKey) const {
+    auto [first, last] = equalRange(aKey);
+    return last - first;
+  }
+
+  // Number of keys in [aLow, aHigh)
+  size_t count(const V& aLow, const V& aHigh) const {
+    return aLow < aHigh ? lowerBound(aHigh) - lowerBound(aLow) : 0;
+  }
+
+  bool contains(const V& aKey) const {
+    return count(aKey) != 0;
+  }
+
+  size_t size() const {
+    return fSize;
+  }
+
+  bool empty() const {
+    return fSize == 0;
+  }
+
+  // Sorted runs besides the buffer
+  size_t runs() const {
+    return fRuns.size();
+  }
+
+  // Merges the buffer and all runs into one run without tombstones, the
+  // fastest layout for a read-only phase
+  void compact() {
+    flush();
+    while (fRuns.size() > 1) {
+      mergeLast();
+    }
+  }
+
+private:
+  struct Run {
+    std::vector<V> keys;       // Sorted
+    std::vector<V> tombstones; // Sorted, each deletes one key of this or an older run
+
+    size_t size() const {
+      return keys.size() + tombstones.size();
+    }
+  };
+
+  template <typename Bound>
+  size_t position(const V& aKey, Bound&& aBound) const {
+    size_t result = aBound(fBuffer.keys, aKey) - aBound(fBuffer.tombstones, aKey);
+    for (const auto& run : fRuns) {
+      result += aBound(run.keys, aKey);
+      result -= aBound(run.tombstones, aKey);
+    }
+    return result;
+  }
+
+  void flushIfFull() {
+    if (fBuffer.size() >= BUFFER_CAPACITY) {
+      flush();
+    }
+  }
+
+  // The buffer becomes the newest run; then, like carries in a binary
+  // counter, runs are merged while the newest is at least half the size of
+  // the one before it
+  void flush() {
+    if (fBuffer.size() == 0) {
+      return;
+    }
+    fRuns.push_back(std::move(fBuffer));
+    fBuffer = Run();
+    while (fRuns.size() > 1 && fRuns[fRuns.size() - 2].size() <= 2 * fRuns.back().size()) {
+      mergeLast();
+    }
+  }
+
+  void mergeLast() {
+    Run newer = std::move(fRuns.back());
+    fRuns.pop_back();
+    Run& older = fRuns.back();
+
+    std::vector<V> keys;
+    keys.reserve(older.keys.size() + newer.keys.size());
+    std::ranges::merge(older.keys, newer.keys, std::back_inserter(keys));
+    std::vector<V> tombstones;
+    tombstones.reserve(older.tombstones.size() + newer.tombstones.size());
+    std::ranges::merge(older.tombstones, newer.tombstones, std::back_inserter(tombstones));
+
+    // Cancel the tombstones whose key is in the merged run; the rest delete
+    // keys of older runs
+    std::vector<V> liveKeys;
+    std::vector<V> liveTombstones;
+    liveKeys.reserve(keys.size());
+    std::ranges::set_difference(keys, tombstones, std::back_inserter(liveKeys));
+    std::ranges::set_difference(tombstones, keys, std::back_inserter(liveTombstones));
+    older.keys = std::move(liveKeys);
+    older.tombstones = std::move(liveTombstones);
+  }
+
+  Run fBuffer;
+  std::vector<Run> fRuns; // Oldest (largest) first
+  size_t fSize = 0;
+};
@@ -0,0 +1,248 @@
+#pragma once
+
+#include "SearchLayouts.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Learned search layouts for BinarySearch: a model predicts where a key sits
+// in the sorted container, and a binary search in a window around the
+// prediction corrects it. The window is the model's largest error over the
+// keys, measured when the model is built, so a present key is always found
+// in it and an absent key is never in it. The container itself is searched;
+// the model is a few segments, not a copy of the keys.
+//
+// Only finite keys are modelled. Infinite keys sit at the ends of the sorted
+// container and are found by their position alone; a NaN query is absent.
+namespace SearchLayout {
+  // A piecewise-linear map from keys to positions in the sorted container
+  template <typename V>
+  class LinearModel {
+    static_assert(std::is_arithmetic_v<V>, "LinearModel interpolates numeric keys");
+
+  public:
+    template <typename Range>
+    int rank(const Range& aSorted, const V& aSearch) const {
+      auto [first, last] = window(aSearch);
+      if (first == last) {
+        return -1;
+      }
+      auto begin = std::ranges::begin(aSorted);
+      auto it = std::lower_bound(begin + first, begin + last, aSearch);
+      return it != begin + last && *it == aSearch ? static_cast<int>(it - begin) : -1;
+    }
+
+    // Predicts the whole group first and prefetches every prediction, so the
+    // window searches mostly hit lines already in flight
+    template <typename Range>
+    void rankBatch(const Range& aSorted, std::span<const V> aQueries, std::span<int> aOut) const {
+      size_t firsts[BATCH_GROUP];
+      size_t lasts[BATCH_GROUP];
+      auto begin = std::ranges::begin(aSorted);
+      for (size_t group = 0; group < aQueries.size(); group += BATCH_GROUP) {
+        size_t count = std::min(BATCH_GROUP, aQueries.size() - group);
+        for (size_t g = 0; g != count; ++g) {
+          std::tie(firsts[g], lasts[g]) = window(aQueries[group + g]);
+          if (firsts[g] != lasts[g]) {
+            __builtin_prefetch(&begin[firsts[g] + (lasts[g] - firsts[g]) / 2]);
+          }
+        }
+        for (size_t g = 0; g != count; ++g) {
+          const V& search = aQueries[group + g];
+          auto it = std::lower_bound(begin + firsts[g], begin + lasts[g], search);
+          aOut[group + g] = it != begin + lasts[g] && *it == search ? static_cast<int>(it - begin) : -1;
+        }
+      }
+    }
+
+    size_t segments() const {
+      return fSegments.size();
+    }
+
+    // Largest window, in keys, over all segments
+    size_t maxError() const {
+      size_t error = 0;
+      for (const auto& segment : fSegments) {
+        error = std::max<size_t>(error, segment.error);
+      }
+      return error;
+    }
+
+  protected:
+    // aEpsilon bounds the error of each segment, fitted greedily: a segment
+    // grows while some line through its first key passes within aEpsilon
+    // positions of all its keys (the shrinking cone of PGM and FITing-tree
+    // indexes). An aEpsilon of 0 fits one line through the first and last
+    // keys instead: interpolation search with a bounded correction.
+    template <typename Range>
+    LinearModel(const Range& aSorted, double aEpsilon)
+        : fSize(std::ranges::size(aSorted)), fFiniteBegin(0), fFiniteEnd(fSize) {
+      auto begin = std::ranges::begin(aSorted);
+      if constexpr (std::is_floating_point_v<V>) {
+        while (fFiniteBegin != fSize && begin[fFiniteBegin] == -std::numeric_limits<V>::infinity()) {
+          ++fFiniteBegin;
+        }
+        while (fFiniteEnd != fFiniteBegin && begin[fFiniteEnd - 1] == std::numeric_limits<V>::infinity()) {
+          --fFiniteEnd;
+        }
+      }
+      // The first occurrence of every distinct finite key, the position
+      // rank() finds
+      std::vector<size_t> points;
+      for (size_t i = fFiniteBegin; i != fFiniteEnd; ++i) {
+        if (i == fFiniteBegin || begin[i - 1] < begin[i]) {
+          points.push_back(i);
+        }
+      }
+      if (points.empty()) {
+        return;
+      }
+
+      if (aEpsilon == 0) {
+        size_t first = points.front();
+        size_t last = points.back();
+        double span = static_cast<double>(begin[last]) - static_cast<double>(begin[first]);
+        double positions = static_cast<double>(last - first);
+        addSegment(begin[first], first, span > 0 ? positions / span : 0);
+      } else {
+        size_t start = points.front();
+        double low = -std::numeric_limits<double>::infinity();
+        double high = std::numeric_limits<double>::infinity();
+        for (size_t point : points) {
+          if (point == start) {
+            continue;
+          }
+          double dx = static_cast<double>(begin[point]) - static_cast<double>(begin[start]);
+          double dy = static_cast<double>(point) - static_cast<double>(start);
+          double newLow = std::max(low, (dy - aEpsilon) / dx);
+          double newHigh = std::min(high, (dy + aEpsilon) / dx);
+          if (newLow <= newHigh) {
+            low = newLow;
+            high = newHigh;
+            continue;
+          }
+          addSegment(begin[start], start, slope(low, high));
+          start = point;
+          low = -std::numeric_limits<double>::infinity();
+          high = std::numeric_limits<double>::infinity();
+        }
+        addSegment(begin[start], start, slope(low, high));
+      }
+
+      // Measure each segment's error with the same arithmetic as queries
+      for (size_t point : points) {
+        size_t index = segmentOf(begin[point]);
+        size_t predicted = predict(index, begin[point]);
+        size_t error = predicted > point ? predicted - point : point - predicted;
+        fSegments[index].error = std::max<size_t>(fSegments[index].error, error);
+      }
+    }
+
+  private:
+    struct Segment {
+      double position; // Of the first key
+      double slope;    // Positions per key
+      uint32_t error = 0;
+    };
+
+    static double slope(double aLow, double aHigh) {
+      if (std::isinf(aLow) || std::isinf(aHigh)) {
+        return 0; // A single key
+      }
+      return (aLow + aHigh) / 2;
+    }
+
+    void addSegment(const V& aFirstKey, size_t aPosition, double aSlope) {
+      fFirstKeys.push_back(aFirstKey);
+      fSegments.push_back({static_cast<double>(aPosition), aSlope});
+    }
+
+    // The last segment starting at or before aKey (the first one for keys
+    // below all of them)
+    size_t segmentOf(const V& aKey) const {
+      auto it = std::upper_bound(fFirstKeys.begin(), fFirstKeys.end(), aKey);
+      return it == fFirstKeys.begin() ? 0 : it - fFirstKeys.begin() - 1;
+    }
+
+    // A position among the finite keys. Keys far apart can overflow the
+    // distance to the segment's first key and make the position NaN (e.g.
+    // an infinite slope times a zero distance); those predict the segment's
+    // first key, and the measured error covers the difference.
+    size_t predict(size_t aSegment, const V& aKey) const {
+      const Segment& segment = fSegments[aSegment];
+      double position =
+          segment.position + segment.slope * (static_cast<double>(aKey) - static_cast<double>(fFirstKeys[aSegment]));
+      if (std::isnan(position)) {
+        position = segment.position;
+      }
+      double clamped = std::clamp(position, static_cast<double>(fFiniteBegin), static_cast<double>(fFiniteEnd - 1));
+      return static_cast<size_t>(std::llround(clamped));
+    }
+
+    // Positions [first, last) that hold aSearch if it is present
+    std::pair<size_t, size_t> window(const V& aSearch) const {
+      if constexpr (std::is_floating_point_v<V>) {
+        if (std::isnan(aSearch)) {
+          return {0, 0};
+        }
+        if (std::isinf(aSearch) && aSearch < 0) {
+          return {0, fFiniteBegin};
+        }
+        if (std::isinf(aSearch)) {
+          return {fFiniteEnd, fSize};
+        }
+      }
+      if (fSegments.empty()) {
+        return {0, 0};
+      }
+      size_t index = segmentOf(aSearch);
+      size_t predicted = predict(index, aSearch);
+      size_t error = fSegments[index].error;
+      return {predicted > fFiniteBegin + error ? predicted - error : fFiniteBegin,
+              std::min(fFiniteEnd, predicted + error + 1)};
+    }
+
+    size_t fSize;
+    size_t fFiniteBegin; // Positions of the finite keys, after any -inf and
+    size_t fFiniteEnd;   // before any +inf
+    std::vector<V> fFirstKeys; // Of each segment, to find a key's segment
+    std::vector<Segment> fSegments;
+  };
+
+  // Piecewise-linear model with at most EPSILON positions of error per
+  // segment: near-uniform keys need few segments, and a search costs one
+  // lookup in the segment keys plus log2(2 * EPSILON + 1) probes. Used as
+  // BinarySearch<T, SearchLayout::LearnedWith<64>::Layout>.
+  template <size_t EPSILON>
+  struct LearnedWith {
+    template <typename V>
+    class Layout : public LinearModel<V> {
+    public:
+      template <typename Range>
+      explicit Layout(const Range& aSorted) : LinearModel<V>(aSorted, static_cast<double>(EPSILON)) {
+      }
+    };
+  };
+
+  template <typename V>
+  using Learned = LearnedWith<32>::Layout<V>;
+
+  // One line from the smallest to the largest key: a constant number of
+  // probes for uniform keys, degrading to a binary search of the measured
+  // error window for skewed ones
+  template <typename V>
+  class Interpolation : public LinearModel<V> {
+  public:
+    template <typename Range>
+    explicit Interpolation(const Range& aSorted) : LinearModel<V>(aSorted, 0) {
+    }
+  };
+} // namespace SearchLayout
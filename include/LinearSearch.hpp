@@ -1,31 +1,138 @@
 #pragma once
 
+#include "LinearSearchKernels.hpp"
+
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <ranges>
+#include <span>
 #include <stdexcept>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/partitioner.h>
+#include <tbb/task_arena.h>
+
+// Non-owning linear search over contiguous elements. The view only holds a
+// span, so rank() does no reference counting and any number of threads can
+// query one view; the elements must outlive it and not change meanwhile.
+template <typename V>
+class LinearSearchView {
+public:
+  explicit LinearSearchView(std::span<const V> aData) : fData(aData) {
+  }
+
+  template <std::ranges::contiguous_range R>
+  explicit LinearSearchView(const R& aData) : fData(std::ranges::data(aData), std::ranges::size(aData)) {
+  }
+
+  // Below this many elements a parallel scan loses to the serial one: the
+  // serial scan takes tens of microseconds, comparable to waking workers
+  static constexpr size_t PARALLEL_THRESHOLD = 1 << 18;
+
+  // Elements each task scans, and between two checks for an earlier match
+  static constexpr size_t CHUNK = 1 << 14;
+
+  int rank(const V& aSearch) const {
+    size_t index = find(0, fData.size(), aSearch);
+    return index == fData.size() ? -1 : static_cast<int>(index); // -1 if not found
+  }
+
+  // rank() with the scan split into chunks across the threads of the
+  // current arena, for containers too large for one core's bandwidth. The
+  // lowest match so far is shared through an atomic, and chunks after it
+  // are skipped, so the scan stops within a chunk per thread of the first
+  // match while still returning it. Small containers are scanned serially.
+  int rankParallel(const V& aSearch) const {
+    size_t size = fData.size();
+    if (size < PARALLEL_THRESHOLD) {
+      return rank(aSearch);
+    }
+
+    std::atomic<size_t> first(size);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, (size + CHUNK - 1) / CHUNK),
+        [&](const tbb::blocked_range<size_t>& aChunks) {
+          for (size_t chunk = aChunks.begin(); chunk != aChunks.end(); ++chunk) {
+            size_t begin = chunk * CHUNK;
+            if (first.load(std::memory_order_relaxed) < begin) {
+              return; // Every later chunk is preceded too
+            }
+            size_t end = std::min(size, begin + CHUNK);
+            size_t index = find(begin, end, aSearch);
+            if (index != end) {
+              size_t current = first.load(std::memory_order_relaxed);
+              while (index < current && !first.compare_exchange_weak(current, index, std::memory_order_relaxed)) {
+              }
+              return;
+            }
+          }
+        },
+        tbb::simple_partitioner());
+    size_t index = first.load(std::memory_order_relaxed);
+    return index == size ? -1 : static_cast<int>(index);
+  }
+
+  // rankParallel() on the threads of aArena
+  int rankParallel(const V& aSearch, tbb::task_arena& aArena) const {
+    return aArena.execute([&] { return rankParallel(aSearch); });
+  }
+
+private:
+  // Index of the first match in [aBegin, aEnd), or aEnd
+  size_t find(size_t aBegin, size_t aEnd, const V& aSearch) const {
+    if constexpr (LinearSearchKernels::Vectorizable<V>) {
+      // Arithmetic elements: compare a vector register at a time
+      return aBegin + LinearSearchKernels::find<V>(fData.data() + aBegin, aEnd - aBegin, aSearch);
+    } else {
+      return std::find(fData.begin() + aBegin, fData.begin() + aEnd, aSearch) - fData.begin();
+    }
+  }
+
+  std::span<const V> fData;
+};
+
+template <std::ranges::contiguous_range R>
+LinearSearchView(const R&) -> LinearSearchView<std::ranges::range_value_t<R>>;
+
+// How LinearSearch scans a contiguous container
+enum class ScanMode {
+  SERIAL,  // On the calling thread
+  PARALLEL // Split across the current arena, above a size threshold (see
+           // LinearSearchView::rankParallel)
+};
 
 template <typename T>
 class LinearSearch {
 public:
-  LinearSearch(std::shared_ptr<T> aData) : fData(aData) {
+  using value_type = std::ranges::range_value_t<T>;
+
+  LinearSearch(std::shared_ptr<T> aData, ScanMode aMode = ScanMode::SERIAL) : fData(aData), fMode(aMode) {
   }
-  int rank(const typename T::value_type& aSearch);
+  int rank(const value_type& aSearch);
 
 private:
   std::weak_ptr<T> fData;
+  ScanMode fMode;
 };
 
 template <typename T>
-int LinearSearch<T>::rank(const typename T::value_type& aSearch) {
-  if (fData.expired()) {
+int LinearSearch<T>::rank(const value_type& aSearch) {
+  auto data = fData.lock();
+  if (!data) {
     throw std::logic_error("Operation on unbound container");
   }
-  auto data = fData.lock();
-  int index = -1;
-  for (const auto& element : *data) {
-    index++;
-    if (element == aSearch) {
-      return index;
+  if constexpr (std::ranges::contiguous_range<T>) {
+    LinearSearchView<value_type> view(*data);
+    return fMode == ScanMode::PARALLEL ? view.rankParallel(aSearch) : view.rank(aSearch);
+  } else {
+    int index = -1;
+    for (const auto& element : *data) {
+      index++;
+      if (element == aSearch) {
+        return index;
+      }
     }
+    return -1; // Not found
   }
-  return -1; // Not found
 }
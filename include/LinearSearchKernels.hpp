@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define MW_LINEAR_SEARCH_X86 1
+#include <immintrin.h>
+#else
+#define MW_LINEAR_SEARCH_X86 0
+#endif
+
+// Vectorized first-match kernels for LinearSearch.
+//
+// find(data, size, value) returns the index of the first element equal to
+// value, or size if there is none, like the scalar loop it replaces. On x86
+// it compares a whole vector register of elements per instruction (16, 32
+// or 64 bytes) and locates the first match with a movemask and a count of
+// trailing zeros. The main loop tests four registers per branch, so a scan
+// that finds nothing is bound by memory bandwidth, not by the compare-and-
+// branch chain. The widest instruction set the CPU supports is picked once
+// at run time, so the header needs no -mavx2 and the binary still runs on
+// older hosts. Other architectures use the scalar loop.
+//
+// Floating-point elements are compared with ordered equality, as operator==
+// does (0.0 matches -0.0, NaN matches nothing).
+namespace LinearSearchKernels {
+  enum class ISA { SCALAR, SSE2, AVX2, AVX512 };
+
+  // Element types with a vector kernel: integers, floats and doubles of 1, 2,
+  // 4 or 8 bytes
+  template <typename T>
+  constexpr bool Vectorizable =
+      (std::is_integral_v<T> && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)) ||
+      std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+  template <typename T>
+  using Kernel = size_t (*)(const T*, size_t, T);
+
+  template <typename T>
+  size_t findScalar(const T* aData, size_t aSize, T aValue) {
+    for (size_t i = 0; i != aSize; ++i) {
+      if (aData[i] == aValue) {
+        return i;
+      }
+    }
+    return aSize;
+  }
+
+#if MW_LINEAR_SEARCH_X86
+  inline unsigned countTrailingZeros(uint64_t aMask) {
+    return static_cast<unsigned>(__builtin_ctzll(aMask));
+  }
+
+  // SSE2 (the x86-64 baseline)
+
+  template <typename T>
+  __attribute__((target("sse2"))) inline __m128i broadcast128(T aValue) {
+    if constexpr (std::is_same_v<T, float>) {
+      return _mm_castps_si128(_mm_set1_ps(aValue));
+    } else if constexpr (std::is_same_v<T, double>) {
+      return _mm_castpd_si128(_mm_set1_pd(aValue));
+    } else if constexpr (sizeof(T) == 1) {
+      return _mm_set1_epi8(static_cast<char>(aValue));
+    } else if constexpr (sizeof(T) == 2) {
+      return _mm_set1_epi16(static_cast<short>(aValue));
+    } else if constexpr (sizeof(T) == 4) {
+      return _mm_set1_epi32(static_cast<int>(aValue));
+    } else {
+      return _mm_set1_epi64x(static_cast<long long>(aValue));
+    }
+  }
+
+  // All bytes of a matching element are set
+  template <typename T>
+  __attribute__((target("sse2"))) inline __m128i equal128(const T* aData, __m128i aNeedle) {
+    if constexpr (std::is_same_v<T, float>) {
+      return _mm_castps_si128(_mm_cmpeq_ps(_mm_loadu_ps(aData), _mm_castsi128_ps(aNeedle)));
+    } else if constexpr (std::is_same_v<T, double>) {
+      return _mm_castpd_si128(_mm_cmpeq_pd(_mm_loadu_pd(aData), _mm_castsi128_pd(aNeedle)));
+    } else {
+      __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aData));
+      if constexpr (sizeof(T) == 1) {
+        return _mm_cmpeq_epi8(data, aNeedle);
+      } else if constexpr (sizeof(T) == 2) {
+        return _mm_cmpeq_epi16(data, aNeedle);
+      } else if constexpr (sizeof(T) == 4) {
+        return _mm_cmpeq_epi32(data, aNeedle);
+      } else {
+        // No 64-bit compare before SSE4.1: both 32-bit halves must match
+        __m128i halves = _mm_cmpeq_epi32(data, aNeedle);
+        return _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+      }
+    }
+  }
+
+  template <typename T>
+  __attribute__((target("sse2"))) size_t findSSE2(const T* aData, size_t aSize, T aValue) {
+    constexpr size_t lanes = 16 / sizeof(T);
+    const __m128i needle = broadcast128(aValue);
+    size_t i = 0;
+    for (; i + 4 * lanes <= aSize; i += 4 * lanes) {
+      __m128i any = _mm_or_si128(_mm_or_si128(equal128(aData + i, needle), equal128(aData + i + lanes, needle)),
+                                 _mm_or_si128(equal128(aData + i + 2 * lanes, needle),
+                                              equal128(aData + i + 3 * lanes, needle)));
+      if (_mm_movemask_epi8(any) != 0) {
+        break; // Located by the loop below
+      }
+    }
+    for (; i + lanes <= aSize; i += lanes) {
+      if (unsigned mask = _mm_movemask_epi8(equal128(aData + i, needle))) {
+        return i + countTrailingZeros(mask) / sizeof(T);
+      }
+    }
+    return i + findScalar(aData + i, aSize - i, aValue);
+  }
+
+  // AVX2
+
+  template <typename T>
+  __attribute__((target("avx2"))) inline __m256i broadcast256(T aValue) {
+    if constexpr (std::is_same_v<T, float>) {
+      return _mm256_castps_si256(_mm256_set1_ps(aValue));
+    } else if constexpr (std::is_same_v<T, double>) {
+      return _mm256_castpd_si256(_mm256_set1_pd(aValue));
+    } else if constexpr (sizeof(T) == 1) {
+      return _mm256_set1_epi8(static_cast<char>(aValue));
+    } else if constexpr (sizeof(T) == 2) {
+      return _mm256_set1_epi16(static_cast<short>(aValue));
+    } else if constexpr (sizeof(T) == 4) {
+      return _mm256_set1_epi32(static_cast<int>(aValue));
+    } else {
+      return _mm256_set1_epi64x(static_cast<long long>(aValue));
+    }
+  }
+
+  template <typename T>
+  __attribute__((target("avx2"))) inline __m256i equal256(const T* aData, __m256i aNeedle) {
+    if constexpr (std::is_same_v<T, float>) {
+      return _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(aData), _mm256_castsi256_ps(aNeedle), _CMP_EQ_OQ));
+    } else if constexpr (std::is_same_v<T, double>) {
+      return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_loadu_pd(aData), _mm256_castsi256_pd(aNeedle), _CMP_EQ_OQ));
+    } else {
+      __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aData));
+      if constexpr (sizeof(T) == 1) {
+        return _mm256_cmpeq_epi8(data, aNeedle);
+      } else if constexpr (sizeof(T) == 2) {
+        return _mm256_cmpeq_epi16(data, aNeedle);
+      } else if constexpr (sizeof(T) == 4) {
+        return _mm256_cmpeq_epi32(data, aNeedle);
+      } else {
+        return _mm256_cmpeq_epi64(data, aNeedle);
+      }
+    }
+  }
+
+  template <typename T>
+  __attribute__((target("avx2"))) size_t findAVX2(const T* aData, size_t aSize, T aValue) {
+    constexpr size_t lanes = 32 / sizeof(T);
+    const __m256i needle = broadcast256(aValue);
+    size_t i = 0;
+    for (; i + 4 * lanes <= aSize; i += 4 * lanes) {
+      __m256i any = _mm256_or_si256(
+          _mm256_or_si256(equal256(aData + i, needle), equal256(aData + i + lanes, needle)),
+          _mm256_or_si256(equal256(aData + i + 2 * lanes, needle), equal256(aData + i + 3 * lanes, needle)));
+      if (!_mm256_testz_si256(any, any)) {
+        break; // Located by the loop below
+      }
+    }
+    for (; i + lanes <= aSize; i += lanes) {
+      if (unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(equal256(aData + i, needle)))) {
+        return i + countTrailingZeros(mask) / sizeof(T);
+      }
+    }
+    return i + findScalar(aData + i, aSize - i, aValue);
+  }
+
+  // AVX-512 (F for 32/64-bit elements, BW for 8/16-bit ones)
+
+  // One mask bit per matching element
+  template <typename T>
+  __attribute__((target("avx512f,avx512bw"))) inline uint64_t equal512(const T* aData, T aValue) {
+    if constexpr (std::is_same_v<T, float>) {
+      return _mm512_cmp_ps_mask(_mm512_loadu_ps(aData), _mm512_set1_ps(aValue), _CMP_EQ_OQ);
+    } else if constexpr (std::is_same_v<T, double>) {
+      return _mm512_cmp_pd_mask(_mm512_loadu_pd(aData), _mm512_set1_pd(aValue), _CMP_EQ_OQ);
+    } else {
+      __m512i data = _mm512_loadu_si512(aData);
+      if constexpr (sizeof(T) == 1) {
+        return _mm512_cmpeq_epi8_mask(data, _mm512_set1_epi8(static_cast<char>(aValue)));
+      } else if constexpr (sizeof(T) == 2) {
+        return _mm512_cmpeq_epi16_mask(data, _mm512_set1_epi16(static_cast<short>(aValue)));
+      } else if constexpr (sizeof(T) == 4) {
+        return _mm512_cmpeq_epi32_mask(data, _mm512_set1_epi32(static_cast<int>(aValue)));
+      } else {
+        return _mm512_cmpeq_epi64_mask(data, _mm512_set1_epi64(static_cast<long long>(aValue)));
+      }
+    }
+  }
+
+  template <typename T>
+  __attribute__((target("avx512f,avx512bw"))) size_t findAVX512(const T* aData, size_t aSize, T aValue) {
+    constexpr size_t lanes = 64 / sizeof(T);
+    size_t i = 0;
+    for (; i + 4 * lanes <= aSize; i += 4 * lanes) {
+      if ((equal512(aData + i, aValue) | equal512(aData + i + lanes, aValue) |
+           equal512(aData + i + 2 * lanes, aValue) | equal512(aData + i + 3 * lanes, aValue)) != 0) {
+        break; // Located by the loop below
+      }
+    }
+    for (; i + lanes <= aSize; i += lanes) {
+      if (uint64_t mask = equal512(aData + i, aValue)) {
+        return i + countTrailingZeros(mask);
+      }
+    }
+    return i + findScalar(aData + i, aSize - i, aValue);
+  }
+#endif
+
+  inline bool supported(ISA aISA) {
+#if MW_LINEAR_SEARCH_X86
+    switch (aISA) {
+      case ISA::SCALAR:
+        return true;
+      case ISA::SSE2:
+        return __builtin_cpu_supports("sse2");
+      case ISA::AVX2:
+        return __builtin_cpu_supports("avx2");
+      case ISA::AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    }
+    return false;
+#else
+    return aISA == ISA::SCALAR;
+#endif
+  }
+
+  // The widest instruction set of this CPU
+  inline ISA best() {
+    constexpr ISA widestFirst[] = {ISA::AVX512, ISA::AVX2, ISA::SSE2};
+    for (ISA isa : widestFirst) {
+      if (supported(isa)) {
+        return isa;
+      }
+    }
+    return ISA::SCALAR;
+  }
+
+  inline const char* name(ISA aISA) {
+    switch (aISA) {
+      case ISA::SCALAR:
+        return "scalar";
+      case ISA::SSE2:
+        return "sse2";
+      case ISA::AVX2:
+        return "avx2";
+      case ISA::AVX512:
+        return "avx512";
+    }
+    return "unknown";
+  }
+
+  // The kernel for aISA, which must be supported
+  template <typename T>
+  Kernel<T> kernel(ISA aISA) {
+    if constexpr (Vectorizable<T>) {
+#if MW_LINEAR_SEARCH_X86
+      switch (aISA) {
+        case ISA::SCALAR:
+          break;
+        case ISA::SSE2:
+          return findSSE2<T>;
+        case ISA::AVX2:
+          return findAVX2<T>;
+        case ISA::AVX512:
+          return findAVX512<T>;
+      }
+#endif
+    }
+    return findScalar<T>;
+  }
+
+  // Index of the first element equal to aValue, or aSize, using the widest
+  // kernel of this CPU (selected on the first call for each T)
+  template <typename T>
+  size_t find(const T* aData, size_t aSize, T aValue) {
+    static const Kernel<T> selected = kernel<T>(best());
+    return selected(aData, aSize, aValue);
+  }
+} // namespace LinearSearchKernels
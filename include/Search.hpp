@@ -0,0 +1,122 @@
+#pragma once
+
+#include "LinearSearch.hpp"
+#include "SearchLayouts.hpp"
+#include "SearchThresholds.hpp"
+#include "SortKeys.hpp"
+
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+// Owning search over a sorted copy of the keys, with the strategy chosen
+// from the number of keys and their type (see SearchThresholds.hpp): a
+// vectorized scan for a few cache lines of keys, then branchless binary
+// search, the Eytzinger layout and the S-tree as the keys outgrow L1 and L2.
+// rank() returns an index of aSearch in the sorted keys whatever the
+// strategy, or -1.
+//
+// The learned layouts are not among the strategies, as their speed depends
+// on the distribution of the keys rather than on their number; use them
+// through BinarySearchIndex.
+template <typename V>
+class Search {
+public:
+  // The strategy the thresholds choose for aSize keys of type V
+  static SearchStrategy choose(size_t aSize) {
+    const auto& crossovers = SearchThresholds::CROSSOVERS<V>;
+    if (aSize < crossovers.binary) {
+      return SearchStrategy::LINEAR;
+    }
+    if (aSize < crossovers.eytzinger) {
+      return SearchStrategy::BINARY;
+    }
+    if (aSize < crossovers.stree || !std::is_arithmetic_v<V>) {
+      return SearchStrategy::EYTZINGER;
+    }
+    return SearchStrategy::STREE;
+  }
+
+  template <std::ranges::input_range R>
+  explicit Search(const R& aKeys) : fSorted(SortKeys::sortedCopy(aKeys)) {
+    build(choose(fSorted.size()));
+  }
+
+  // Forces aStrategy regardless of the thresholds, e.g. to calibrate them
+  template <std::ranges::input_range R>
+  Search(const R& aKeys, SearchStrategy aStrategy) : fSorted(SortKeys::sortedCopy(aKeys)) {
+    build(aStrategy);
+  }
+
+  int rank(const V& aSearch) const {
+    return std::visit(
+        [&](const auto& aLayout) {
+          if constexpr (std::is_same_v<std::decay_t<decltype(aLayout)>, std::monostate>) {
+            return LinearSearchView<V>(fSorted).rank(aSearch);
+          } else {
+            return aLayout.rank(fSorted, aSearch);
+          }
+        },
+        fLayout);
+  }
+
+  // rank() of every query into aOut (at least as long as aQueries)
+  void rankBatch(std::span<const V> aQueries, std::span<int> aOut) const {
+    if (aOut.size() < aQueries.size()) {
+      throw std::invalid_argument("Output shorter than the queries");
+    }
+    std::visit(
+        [&](const auto& aLayout) {
+          if constexpr (std::is_same_v<std::decay_t<decltype(aLayout)>, std::monostate>) {
+            LinearSearchView<V> view(fSorted);
+            for (size_t i = 0; i != aQueries.size(); ++i) {
+              aOut[i] = view.rank(aQueries[i]);
+            }
+          } else {
+            aLayout.rankBatch(fSorted, aQueries, aOut);
+          }
+        },
+        fLayout);
+  }
+
+  SearchStrategy strategy() const {
+    return static_cast<SearchStrategy>(fLayout.index());
+  }
+
+  std::span<const V> sorted() const {
+    return fSorted;
+  }
+
+private:
+  // Alternatives in SearchStrategy order; the linear scan needs no layout
+  using Layouts = std::conditional_t<
+      std::is_arithmetic_v<V>,
+      std::variant<std::monostate, SearchLayout::Branchless<V>, SearchLayout::Eytzinger<V>, SearchLayout::STree<V>>,
+      std::variant<std::monostate, SearchLayout::Branchless<V>, SearchLayout::Eytzinger<V>>>;
+
+  void build(SearchStrategy aStrategy) {
+    switch (aStrategy) {
+      case SearchStrategy::LINEAR:
+        return;
+      case SearchStrategy::BINARY:
+        fLayout.template emplace<SearchLayout::Branchless<V>>(fSorted);
+        return;
+      case SearchStrategy::EYTZINGER:
+        fLayout.template emplace<SearchLayout::Eytzinger<V>>(fSorted);
+        return;
+      case SearchStrategy::STREE:
+        if constexpr (std::is_arithmetic_v<V>) {
+          fLayout.template emplace<SearchLayout::STree<V>>(fSorted);
+          return;
+        }
+        break;
+    }
+    throw std::invalid_argument("Search strategy not available for this key type");
+  }
+
+  std::vector<V> fSorted;
+  Layouts fLayout;
+};
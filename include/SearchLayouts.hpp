@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Memory layouts of a sorted array for BinarySearch.
+//
+// A layout is built once from the sorted container and answers rank(): the
+// index of aSearch in that sorted order, or -1. Sorted searches the
+// container itself; the others keep their own copy of the keys in an order
+// where the top of the search tree shares cache lines, plus the sorted index
+// of every slot to map a hit back to its rank.
+//
+// rankBatch() answers many queries at once with group prefetching: the
+// searches of BATCH_GROUP queries advance one level at a time in lockstep,
+// so their loads are independent and their cache misses overlap instead of
+// forming one dependent chain per query.
+namespace SearchLayout {
+  constexpr size_t CACHE_LINE = 64;
+
+  // Queries in flight per group: enough to cover memory latency with the
+  // line fill buffers of one core, few enough for their state to stay in
+  // registers and L1
+  constexpr size_t BATCH_GROUP = 32;
+
+  // Allocator of cache-line-aligned arrays, so that a tree node or a block of
+  // Eytzinger descendants never straddles two lines
+  template <typename V>
+  struct CacheAligned {
+    using value_type = V;
+
+    CacheAligned() = default;
+    template <typename U>
+    CacheAligned(const CacheAligned<U>&) {
+    }
+
+    V* allocate(size_t aCount) {
+      return static_cast<V*>(::operator new(aCount * sizeof(V), std::align_val_t(CACHE_LINE)));
+    }
+    void deallocate(V* aPointer, size_t) {
+      ::operator delete(aPointer, std::align_val_t(CACHE_LINE));
+    }
+
+    template <typename U>
+    bool operator==(const CacheAligned<U>&) const {
+      return true;
+    }
+  };
+
+  template <typename V>
+  using AlignedVector = std::vector<V, CacheAligned<V>>;
+
+  // Textbook binary search over the sorted container
+  template <typename V>
+  class Sorted {
+  public:
+    template <typename Range>
+    explicit Sorted(const Range&) {
+    }
+
+    template <typename Range>
+    int rank(const Range& aSorted, const V& aSearch) const {
+      int low = 0;
+      int high = static_cast<int>(std::ranges::size(aSorted)) - 1;
+
+      while (low <= high) {
+        int mid = low + (high - low) / 2;
+        if (aSorted[mid] < aSearch) {
+          low = mid + 1;
+        } else if (aSorted[mid] > aSearch) {
+          high = mid - 1;
+        } else if (aSorted[mid] == aSearch) {
+          return mid; // Found
+        } else {
+          return -1; // Unordered: a NaN is equal to nothing
+        }
+      }
+
+      return -1; // Not found
+    }
+
+    // Branchless lower bound per query. With duplicate keys this may return
+    // a different matching index than rank().
+    template <typename Range>
+    void rankBatch(const Range& aSorted, std::span<const V> aQueries, std::span<int> aOut) const {
+      size_t size = std::ranges::size(aSorted);
+      if (size == 0) {
+        std::ranges::fill(aOut.first(aQueries.size()), -1);
+        return;
+      }
+      size_t base[BATCH_GROUP];
+      for (size_t first = 0; first < aQueries.size(); first += BATCH_GROUP) {
+        size_t count = std::min(BATCH_GROUP, aQueries.size() - first);
+        const V* queries = aQueries.data() + first;
+        std::fill_n(base, count, 0);
+        for (size_t length = size; length > 1;) {
+          size_t half = length / 2;
+          length -= half;
+          for (size_t g = 0; g != count; ++g) {
+            base[g] += (aSorted[base[g] + half - 1] < queries[g]) * half;
+          }
+          // The next level's probes, loaded after the rest of the group
+          for (size_t g = 0; g != count && length > 1; ++g) {
+            __builtin_prefetch(&aSorted[base[g] + length / 2 - 1]);
+          }
+        }
+        for (size_t g = 0; g != count; ++g) {
+          aOut[first + g] = aSorted[base[g]] == queries[g] ? static_cast<int>(base[g]) : -1;
+        }
+      }
+    }
+  };
+
+  // Sorted order searched without data-dependent branches: the lower bound
+  // is narrowed by conditional moves, so the loop runs exactly log2(n) times
+  // and never mispredicts. Loses to the textbook search when the array is
+  // much larger than the caches, since it cannot stop at an early match and
+  // the CPU cannot speculate the next probe.
+  template <typename V>
+  class Branchless : public Sorted<V> {
+  public:
+    template <typename Range>
+    explicit Branchless(const Range& aSorted) : Sorted<V>(aSorted) {
+    }
+
+    template <typename Range>
+    int rank(const Range& aSorted, const V& aSearch) const {
+      size_t size = std::ranges::size(aSorted);
+      if (size == 0) {
+        return -1;
+      }
+      size_t base = 0;
+      for (size_t length = size; length > 1;) {
+        size_t half = length / 2;
+        base = aSorted[base + half - 1] < aSearch ? base + half : base;
+        length -= half;
+      }
+      return aSorted[base] == aSearch ? static_cast<int>(base) : -1;
+    }
+  };
+
+  // Keys in breadth-first (Eytzinger) order: the children of slot k are 2k
+  // and 2k + 1, so the first levels of every search hit the same few cache
+  // lines. The descent has no data-dependent branch, and it prefetches the
+  // cache line holding k's descendants several levels down (four for 4-byte
+  // keys: 16 of them), so that line is in flight while the levels in between
+  // are compared.
+  template <typename V>
+  class Eytzinger {
+  public:
+    template <typename Range>
+    explicit Eytzinger(const Range& aSorted)
+        : fKeys(std::ranges::size(aSorted) + 1), fRanks(std::ranges::size(aSorted) + 1, -1) {
+      auto it = std::ranges::begin(aSorted);
+      int rank = 0;
+      build(1, it, rank);
+    }
+
+    template <typename Range>
+    int rank(const Range&, const V& aSearch) const {
+      size_t size = fKeys.size() - 1;
+      size_t k = 1;
+      while (k <= size) {
+        __builtin_prefetch(fKeys.data() + k * PREFETCH_STRIDE);
+        k = 2 * k + (fKeys[k] < aSearch);
+      }
+      return result(k, aSearch);
+    }
+
+    template <typename Range>
+    void rankBatch(const Range&, std::span<const V> aQueries, std::span<int> aOut) const {
+      size_t size = fKeys.size() - 1;
+      size_t slots[BATCH_GROUP];
+      for (size_t first = 0; first < aQueries.size(); first += BATCH_GROUP) {
+        size_t count = std::min(BATCH_GROUP, aQueries.size() - first);
+        const V* queries = aQueries.data() + first;
+        std::fill_n(slots, count, 1);
+        // Every descent takes the same number of levels give or take one
+        for (bool descending = true; descending;) {
+          descending = false;
+          for (size_t g = 0; g != count; ++g) {
+            size_t k = slots[g];
+            if (k <= size) {
+              __builtin_prefetch(fKeys.data() + k * PREFETCH_STRIDE);
+              slots[g] = 2 * k + (fKeys[k] < queries[g]);
+              descending = true;
+            }
+          }
+        }
+        for (size_t g = 0; g != count; ++g) {
+          aOut[first + g] = result(slots[g], queries[g]);
+        }
+      }
+    }
+
+  private:
+    // Rank of aSearch from the slot where its descent left the tree.
+    // Undoing the right turns taken after the last left turn gives the slot
+    // of the first key not less than aSearch (0 if there is none).
+    int result(size_t aSlot, const V& aSearch) const {
+      aSlot >>= __builtin_ffsll(static_cast<long long>(~aSlot));
+      return aSlot != 0 && fKeys[aSlot] == aSearch ? fRanks[aSlot] : -1;
+    }
+
+    // Slot k * PREFETCH_STRIDE is the leftmost of a full cache line of k's
+    // descendants (the array is aligned, and the stride a power of two)
+    static constexpr size_t PREFETCH_STRIDE = sizeof(V) < CACHE_LINE ? CACHE_LINE / sizeof(V) : 1;
+
+    // In-order traversal of the implicit tree assigns the sorted keys
+    template <typename Iterator>
+    void build(size_t aSlot, Iterator& aIt, int& aRank) {
+      if (aSlot < fKeys.size()) {
+        build(2 * aSlot, aIt, aRank);
+        fKeys[aSlot] = *aIt++;
+        fRanks[aSlot] = aRank++;
+        build(2 * aSlot + 1, aIt, aRank);
+      }
+    }
+
+    AlignedVector<V> fKeys; // Slot 0 is unused
+    std::vector<int> fRanks;
+  };
+
+  // Static B-tree (S-tree): nodes of one cache line of keys, numbered in
+  // breadth-first order with node k's children at k * (B + 1) + 1 + i. A
+  // search touches one cache line per level, log_{B+1}(n) levels instead
+  // of log2(n), and ranks aSearch within a node by counting the keys less
+  // than it, a fixed-length loop the compiler vectorizes. Slots past the
+  // last key are padded with the largest value of V: infinity for floating
+  // point, since a key of infinity would be greater than max().
+  template <typename V>
+  class STree {
+    static_assert(std::is_arithmetic_v<V>, "STree pads nodes with the largest value of V");
+
+  public:
+    static constexpr size_t B = sizeof(V) < CACHE_LINE ? CACHE_LINE / sizeof(V) : 1; // Keys per node
+
+    template <typename Range>
+    explicit STree(const Range& aSorted) {
+      size_t size = std::ranges::size(aSorted);
+      fNodes = (size + B - 1) / B;
+      fKeys.assign(fNodes * B, PADDING);
+      fRanks.assign(fNodes * B, -1);
+      auto it = std::ranges::begin(aSorted);
+      auto end = std::ranges::end(aSorted);
+      int rank = 0;
+      build(0, it, end, rank);
+    }
+
+    template <typename Range>
+    int rank(const Range&, const V& aSearch) const {
+      size_t candidate = NONE;
+      size_t k = 0;
+      while (k < fNodes) {
+        k = step(k, aSearch, candidate);
+      }
+      return result(candidate, aSearch);
+    }
+
+    template <typename Range>
+    void rankBatch(const Range&, std::span<const V> aQueries, std::span<int> aOut) const {
+      size_t nodes[BATCH_GROUP];
+      size_t candidates[BATCH_GROUP];
+      for (size_t first = 0; first < aQueries.size(); first += BATCH_GROUP) {
+        size_t count = std::min(BATCH_GROUP, aQueries.size() - first);
+        const V* queries = aQueries.data() + first;
+        std::fill_n(nodes, count, 0);
+        std::fill_n(candidates, count, NONE);
+        for (bool descending = true; descending;) {
+          descending = false;
+          for (size_t g = 0; g != count; ++g) {
+            if (nodes[g] < fNodes) {
+              nodes[g] = step(nodes[g], queries[g], candidates[g]);
+              __builtin_prefetch(fKeys.data() + nodes[g] * B);
+              descending = true;
+            }
+          }
+        }
+        for (size_t g = 0; g != count; ++g) {
+          aOut[first + g] = result(candidates[g], queries[g]);
+        }
+      }
+    }
+
+  private:
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+    static constexpr V PADDING =
+        std::is_floating_point_v<V> ? std::numeric_limits<V>::infinity() : std::numeric_limits<V>::max();
+
+    // Ranks aSearch in node aNode and returns the child to descend to.
+    // node[i] is the first key of this node not less than aSearch; keys
+    // further down are smaller, so the deepest such slot is the lower bound.
+    size_t step(size_t aNode, const V& aSearch, size_t& aCandidate) const {
+      const V* node = fKeys.data() + aNode * B;
+      size_t i = 0;
+      for (size_t j = 0; j != B; ++j) {
+        i += node[j] < aSearch;
+      }
+      aCandidate = i != B ? aNode * B + i : aCandidate;
+      return aNode * (B + 1) + 1 + i;
+    }
+
+    // Padding is ordered after every key, or equal to the largest, which
+    // precedes it in order; a padding candidate means no key is at least
+    // aSearch
+    int result(size_t aCandidate, const V& aSearch) const {
+      if (aCandidate == NONE || fKeys[aCandidate] != aSearch) {
+        return -1;
+      }
+      return fRanks[aCandidate];
+    }
+
+    template <typename Iterator, typename Sentinel>
+    void build(size_t aNode, Iterator& aIt, const Sentinel& aEnd, int& aRank) {
+      if (aNode >= fNodes) {
+        return;
+      }
+      for (size_t i = 0; i != B; ++i) {
+        build(aNode * (B + 1) + 1 + i, aIt, aEnd, aRank);
+        if (aIt != aEnd) {
+          fKeys[aNode * B + i] = *aIt++;
+          fRanks[aNode * B + i] = aRank++;
+        }
+      }
+      build(aNode * (B + 1) + 1 + B, aIt, aEnd, aRank);
+    }
+
+    size_t fNodes = 0;
+    AlignedVector<V> fKeys;
+    std::vector<int> fRanks;
+  };
+} // namespace SearchLayout
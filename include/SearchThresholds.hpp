@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Strategies of Search<V>, from the smallest containers to the largest
+enum class SearchStrategy {
+  LINEAR,    // Vectorized scan of the sorted keys
+  BINARY,    // Branchless binary search of the sorted keys
+  EYTZINGER, // Branchless descent of the keys in breadth-first order
+  STREE      // Static B-tree of one cache line per node (numeric keys)
+};
+
+inline const char* strategyName(SearchStrategy aStrategy) {
+  switch (aStrategy) {
+    case SearchStrategy::LINEAR:
+      return "linear";
+    case SearchStrategy::BINARY:
+      return "binary";
+    case SearchStrategy::EYTZINGER:
+      return "eytzinger";
+    case SearchStrategy::STREE:
+      return "stree";
+  }
+  return "";
+}
+
+// Container sizes at which Search<V> switches strategy. A container of n
+// keys is searched linearly below `binary`, by branchless binary search from
+// `binary` to `eytzinger`, and so on; a crossover of NEVER skips its
+// strategy, and equal crossovers skip the strategies between them.
+//
+// The defaults below are the output of that calibration, run twice on one
+// core of an x86-64 server with AVX-512: the vectorized scan lost to binary
+// search at every size down to a single key, as calling the dispatched
+// kernel costs more than a few branchless probes, and the S-tree overtook
+// the Eytzinger layout only for floats, at 512K keys. The runs disagreed
+// only on the Eytzinger crossovers of the integers (16K and 128K keys for
+// int32_t, 128 and 8K for int64_t), where the two layouts are within a few
+// percent of each other; 16K and 8K are kept. To tune them for another
+// machine, run
+//
+//   tLogarithmicComplexityExample --calibrate=<path>
+//
+// which times every strategy for each key type over sizes from 1 to 1M keys
+// and writes the best crossovers to <path> as specializations of
+// CROSSOVERS, then configure with -DMW_SEARCH_THRESHOLDS=<path> so that this
+// header includes them.
+namespace SearchThresholds {
+  constexpr size_t NEVER = std::numeric_limits<size_t>::max();
+
+  struct Crossovers {
+    size_t binary;
+    size_t eytzinger;
+    size_t stree;
+  };
+
+  // Key types without a calibration of their own
+  template <typename V>
+  inline constexpr Crossovers CROSSOVERS = {8, 8192, NEVER};
+} // namespace SearchThresholds
+
+#ifdef MW_SEARCH_THRESHOLDS
+#include MW_SEARCH_THRESHOLDS
+#else
+namespace SearchThresholds {
+  template <>
+  inline constexpr Crossovers CROSSOVERS<int32_t> = {1, 16384, NEVER};
+
+  template <>
+  inline constexpr Crossovers CROSSOVERS<int64_t> = {1, 8192, NEVER};
+
+  template <>
+  inline constexpr Crossovers CROSSOVERS<float> = {1, 16384, 524288};
+
+  template <>
+  inline constexpr Crossovers CROSSOVERS<double> = {1, 16384, NEVER};
+} // namespace SearchThresholds
+#endif
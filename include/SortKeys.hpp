@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_sort.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Sorting for search index construction.
+//
+// sort() first checks in O(n) whether the keys are already sorted, which is
+// common (keys appended in order, indexes rebuilt from sorted dumps) and
+// then costs one sequential read instead of an O(n log n) sort. Small inputs
+// use std::sort. Large contiguous integer keys use an LSD radix sort, which
+// does a fixed number of sequential passes instead of log(n) levels of
+// comparisons. Other large inputs use TBB's parallel sort.
+namespace SortKeys {
+  // Below this many keys the serial algorithms win over the cost of
+  // spawning tasks or of the radix sort's passes and buffer
+  constexpr size_t PARALLEL_THRESHOLD = 1 << 16;
+
+  // Integer keys with a radix sort: one 8-bit digit per byte
+  template <typename V>
+  constexpr bool RadixSortable = std::is_integral_v<V> && !std::is_same_v<V, bool>;
+
+  // Whether aKeys is in non-decreasing order, checked in parallel chunks for
+  // large inputs
+  template <std::ranges::random_access_range R>
+  bool isSorted(const R& aKeys) {
+    size_t size = std::ranges::size(aKeys);
+    if (size < PARALLEL_THRESHOLD) {
+      return std::ranges::is_sorted(aKeys);
+    }
+    auto begin = std::ranges::begin(aKeys);
+    return tbb::parallel_reduce(
+        tbb::blocked_range<size_t>(1, size), true,
+        [&](const tbb::blocked_range<size_t>& aChunk, bool aSorted) {
+          // Each chunk also compares its first key with the one before it
+          return aSorted && std::is_sorted(begin + (aChunk.begin() - 1), begin + aChunk.end());
+        },
+        [](bool aLeft, bool aRight) { return aLeft && aRight; });
+  }
+
+  // LSD radix sort of integer keys, one byte per pass, skipping the passes
+  // in which every key has the same digit (e.g. the high bytes of small
+  // keys). Signed keys are ordered by flipping their sign bit.
+  template <typename V>
+    requires RadixSortable<V>
+  void radixSort(std::span<V> aKeys) {
+    using U = std::make_unsigned_t<V>;
+    constexpr size_t PASSES = sizeof(V);
+    constexpr U SIGN = std::is_signed_v<V> ? U(1) << (8 * sizeof(V) - 1) : U(0);
+    auto digit = [](V aKey, size_t aPass) {
+      return static_cast<uint8_t>((static_cast<U>(aKey) ^ SIGN) >> (8 * aPass));
+    };
+
+    // The histograms of all passes in one read of the keys
+    std::vector<std::array<size_t, 256>> counts(PASSES);
+    for (V key : aKeys) {
+      for (size_t pass = 0; pass != PASSES; ++pass) {
+        ++counts[pass][digit(key, pass)];
+      }
+    }
+
+    std::vector<V> buffer(aKeys.size());
+    std::span<V> from = aKeys;
+    std::span<V> to = buffer;
+    for (size_t pass = 0; pass != PASSES; ++pass) {
+      auto& count = counts[pass];
+      if (std::ranges::find(count, aKeys.size()) != count.end()) {
+        continue; // One digit for all keys
+      }
+      size_t offset = 0;
+      for (auto& bucket : count) {
+        offset += std::exchange(bucket, offset);
+      }
+      for (V key : from) {
+        to[count[digit(key, pass)]++] = key;
+      }
+      std::swap(from, to);
+    }
+    if (from.data() != aKeys.data()) {
+      std::ranges::copy(from, aKeys.begin());
+    }
+  }
+
+  template <std::ranges::random_access_range R>
+  void parallelSort(R& aKeys) {
+    tbb::parallel_sort(std::ranges::begin(aKeys), std::ranges::end(aKeys));
+  }
+
+  // Sorts aKeys in place, unless they already are
+  template <std::ranges::random_access_range R>
+  void sort(R& aKeys) {
+    using V = std::ranges::range_value_t<R>;
+    if (isSorted(aKeys)) {
+      return;
+    }
+    if (std::ranges::size(aKeys) < PARALLEL_THRESHOLD) {
+      std::ranges::sort(aKeys);
+    } else if constexpr (std::ranges::contiguous_range<R> && RadixSortable<V>) {
+      radixSort(std::span<V>(std::ranges::data(aKeys), std::ranges::size(aKeys)));
+    } else {
+      parallelSort(aKeys);
+    }
+  }
+
+  // A sorted copy of aKeys, which are left as they are
+  template <std::ranges::input_range R>
+  std::vector<std::ranges::range_value_t<R>> sortedCopy(const R& aKeys) {
+    std::vector<std::ranges::range_value_t<R>> sorted(std::ranges::begin(aKeys), std::ranges::end(aKeys));
+    sort(sorted);
+    return sorted;
+  }
+
+  // The indices of aKeys in key order (ties in index order), so that
+  // aKeys[permutation[i]] is the i-th smallest key; aKeys are left as they
+  // are. 32-bit indices, as ranks are ints.
+  template <std::ranges::random_access_range R>
+  std::vector<uint32_t> sortedPermutation(const R& aKeys) {
+    size_t size = std::ranges::size(aKeys);
+    std::vector<uint32_t> permutation(size);
+    std::iota(permutation.begin(), permutation.end(), 0);
+    if (isSorted(aKeys)) {
+      return permutation;
+    }
+    auto begin = std::ranges::begin(aKeys);
+    auto byKey = [begin](uint32_t aLeft, uint32_t aRight) {
+      return begin[aLeft] < begin[aRight] || (!(begin[aRight] < begin[aLeft]) && aLeft < aRight);
+    };
+    if (size < PARALLEL_THRESHOLD) {
+      std::ranges::sort(permutation, byKey);
+    } else {
+      tbb::parallel_sort(permutation.begin(), permutation.end(), byKey);
+    }
+    return permutation;
+  }
+} // namespace SortKeys
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Seeded generator of synthetic IR for value numbering and GVN stress tests.
+//
+// Every function has the signature i64 (i64 %n, i64 %a, i64 %b, ptr %mem)
+// and is a chain of blocks, so each block dominates all later ones and any
+// earlier value can be an operand. A block is either straight-line code or a
+// single-block loop (counted by %n) with PHIs carrying values around the back
+// edge. Instructions are integer binary operators, loads and stores through
+// %mem at a few fixed offsets. A share of them repeats an earlier expression,
+// optionally with commutative operands swapped, which is the redundancy
+// numbering is meant to find.
+//
+// Generation is deterministic for a given Options, so fixtures can build
+// their inputs in memory instead of parsing checked-in IR.
+namespace SyntheticIR {
+  struct Options {
+    unsigned functions = 1;
+    unsigned blocks = 8;                 // Per function
+    unsigned instructionsPerBlock = 64;  // Excluding PHIs and terminators
+    double redundancy = 0.25;            // Share of repeated expressions
+    double commutativeSwap = 0.5;        // Share of repeats with operands swapped
+    double loopDensity = 0.1;            // Share of blocks that are loops
+    unsigned phisPerLoop = 2;            // Loop-carried values besides the counter
+    double memoryRatio = 0.1;            // Share of loads and stores
+    double storeRatio = 0.3;             // Share of stores among memory instructions
+    unsigned memorySlots = 16;           // Distinct addresses in %mem
+    uint64_t seed = 1;
+  };
+
+  class Generator {
+  public:
+    Generator(llvm::LLVMContext& aContext, const Options& aOptions)
+        : fContext(aContext),
+          fOptions(aOptions),
+          fRng(aOptions.seed),
+          fInt(llvm::Type::getInt64Ty(aContext)),
+          fPtr(llvm::PointerType::get(fInt, 0)),
+          fBuilder(aContext) {
+    }
+
+    std::unique_ptr<llvm::Module> generate(const std::string& aName = "synthetic") {
+      auto module = std::make_unique<llvm::Module>(aName, fContext);
+      auto* type = llvm::FunctionType::get(fInt, {fInt, fInt, fInt, fPtr}, false);
+      for (unsigned i = 0; i < fOptions.functions; ++i) {
+        auto* function = llvm::Function::Create(
+            type, llvm::Function::ExternalLinkage, "f" + std::to_string(i), module.get());
+        generateFunction(*function);
+      }
+      return module;
+    }
+
+  private:
+    struct Expression {
+      unsigned opcode;
+      llvm::Value* lhs; // Address for loads
+      llvm::Value* rhs;
+    };
+
+    bool chance(double aProbability) {
+      return std::uniform_real_distribution<double>(0, 1)(fRng) < aProbability;
+    }
+
+    size_t below(size_t aBound) {
+      return std::uniform_int_distribution<size_t>(0, aBound - 1)(fRng);
+    }
+
+    // Mostly recent values, so that expression chains form
+    llvm::Value* pickOperand() {
+      size_t window = std::min<size_t>(fValues.size(), 32);
+      return fValues[fValues.size() - 1 - below(window)];
+    }
+
+    void generateFunction(llvm::Function& aFunction) {
+      fValues.clear();
+      fExpressions.clear();
+      fAddresses.clear();
+      fTripCount = aFunction.getArg(0);
+      fMemory = aFunction.getArg(3);
+      fTripCount->setName("n");
+      aFunction.getArg(1)->setName("a");
+      aFunction.getArg(2)->setName("b");
+      fMemory->setName("mem");
+      fValues.push_back(aFunction.getArg(1));
+      fValues.push_back(aFunction.getArg(2));
+
+      auto* block = llvm::BasicBlock::Create(fContext, "entry", &aFunction);
+      fBuilder.SetInsertPoint(block);
+      if (fOptions.memoryRatio > 0) {
+        for (unsigned i = 0; i < std::max(fOptions.memorySlots, 1u); ++i) {
+          fAddresses.push_back(fBuilder.CreateGEP(fInt, fMemory, fBuilder.getInt64(i)));
+        }
+      }
+
+      for (unsigned b = 0; b < fOptions.blocks; ++b) {
+        if (b != 0 && chance(fOptions.loopDensity)) {
+          generateLoop(aFunction);
+        } else {
+          generateInstructions(fOptions.instructionsPerBlock);
+        }
+        if (b + 1 != fOptions.blocks) {
+          auto* next = llvm::BasicBlock::Create(fContext, "bb", &aFunction);
+          fBuilder.CreateBr(next);
+          fBuilder.SetInsertPoint(next);
+        }
+      }
+      fBuilder.CreateRet(fValues.back());
+    }
+
+    // A single-block loop: the counter and phisPerLoop values are carried
+    // around the back edge, the body recomputes them and exits after %n trips
+    void generateLoop(llvm::Function& aFunction) {
+      auto* preheader = fBuilder.GetInsertBlock();
+      auto* loop = llvm::BasicBlock::Create(fContext, "loop", &aFunction);
+      auto* exit = llvm::BasicBlock::Create(fContext, "loop.exit", &aFunction);
+      fBuilder.CreateBr(loop);
+      fBuilder.SetInsertPoint(loop);
+
+      auto* counter = fBuilder.CreatePHI(fInt, 2, "i");
+      counter->addIncoming(fBuilder.getInt64(0), preheader);
+      std::vector<llvm::PHINode*> carried;
+      for (unsigned i = 0; i < fOptions.phisPerLoop; ++i) {
+        auto* phi = fBuilder.CreatePHI(fInt, 2);
+        phi->addIncoming(pickOperand(), preheader);
+        carried.push_back(phi);
+      }
+      for (auto* phi : carried) {
+        fValues.push_back(phi);
+      }
+
+      generateInstructions(fOptions.instructionsPerBlock);
+
+      for (auto* phi : carried) {
+        phi->addIncoming(pickOperand(), loop);
+      }
+      auto* next = fBuilder.CreateAdd(counter, fBuilder.getInt64(1), "i.next");
+      counter->addIncoming(next, loop);
+      fBuilder.CreateCondBr(fBuilder.CreateICmpSLT(next, fTripCount), loop, exit);
+      fBuilder.SetInsertPoint(exit);
+    }
+
+    void generateInstructions(unsigned aCount) {
+      static const unsigned binaryOpcodes[] = {
+          llvm::Instruction::Add, llvm::Instruction::Mul, llvm::Instruction::Sub,
+          llvm::Instruction::Xor, llvm::Instruction::And, llvm::Instruction::Or,
+          llvm::Instruction::Shl};
+
+      for (unsigned i = 0; i < aCount; ++i) {
+        if (!fAddresses.empty() && chance(fOptions.memoryRatio)) {
+          auto* address = fAddresses[below(fAddresses.size())];
+          if (chance(fOptions.storeRatio)) {
+            fBuilder.CreateStore(pickOperand(), address);
+            continue;
+          }
+          if (!fExpressions.empty() && chance(fOptions.redundancy)) {
+            // Reload an address loaded before
+            for (auto it = fExpressions.rbegin(); it != fExpressions.rend(); ++it) {
+              if (it->opcode == llvm::Instruction::Load) {
+                address = it->lhs;
+                break;
+              }
+            }
+          }
+          fValues.push_back(fBuilder.CreateLoad(fInt, address));
+          fExpressions.push_back({llvm::Instruction::Load, address, nullptr});
+          continue;
+        }
+
+        Expression expression;
+        bool repeat = false;
+        if (!fExpressions.empty() && chance(fOptions.redundancy)) {
+          expression = fExpressions[below(fExpressions.size())];
+          repeat = expression.opcode != llvm::Instruction::Load;
+        }
+        if (repeat) {
+          if (llvm::Instruction::isCommutative(expression.opcode) && chance(fOptions.commutativeSwap)) {
+            std::swap(expression.lhs, expression.rhs);
+          }
+        } else {
+          expression = {binaryOpcodes[below(std::size(binaryOpcodes))], pickOperand(), pickOperand()};
+          fExpressions.push_back(expression);
+        }
+        fValues.push_back(fBuilder.CreateBinOp(
+            static_cast<llvm::Instruction::BinaryOps>(expression.opcode), expression.lhs, expression.rhs));
+      }
+    }
+
+    llvm::LLVMContext& fContext;
+    Options fOptions;
+    std::mt19937_64 fRng;
+    llvm::Type* fInt;
+    llvm::PointerType* fPtr;
+    llvm::IRBuilder<> fBuilder;
+    llvm::Value* fTripCount = nullptr;
+    llvm::Value* fMemory = nullptr;
+    std::vector<llvm::Value*> fValues;       // Available (dominating) integer values
+    std::vector<Expression> fExpressions;    // Distinct expressions generated so far
+    std::vector<llvm::Value*> fAddresses;    // One GEP per memory slot, in the entry block
+  };
+
+  inline std::unique_ptr<llvm::Module> generate(llvm::LLVMContext& aContext,
+                                                const Options& aOptions,
+                                                const std::string& aName = "synthetic") {
+    return Generator(aContext, aOptions).generate(aName);
+  }
+} // namespace SyntheticIR
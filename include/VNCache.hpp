@@ -0,0 +1,349 @@
+#pragma once
+
+#include "LLVMValueNumbering.hpp"
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalValue.h>
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Instructions.h>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+// Persistent, content-addressed cache of congruence classes.
+//
+// Value numbers are derived from pointers and llvm::hash_code, so they are not
+// stable between runs. What is cached instead is the partition: one dense
+// class id per instruction, in function layout order. A function is
+// identified by a structural hash that is stable across processes, so an
+// unchanged function in an incremental build costs a hash and a file read.
+//
+// A partition says nothing about how one function's classes relate to
+// another's, so numbering through the cache is function-local: instructions
+// of different functions are never congruent, whether the classes were
+// reloaded or just computed (see numberFunction()).
+namespace VNCache {
+  // Bump whenever the numbering or the file layout changes meaning
+  constexpr uint32_t FORMAT_VERSION = 4;
+  constexpr uint32_t MAGIC = 0x4e56574d; // "MWVN"
+
+  // 64-bit mixing that, unlike llvm::hash_code, is identical in every process
+  inline uint64_t mix(uint64_t aHash, uint64_t aValue) {
+    aHash ^= aValue + 0x9e3779b97f4a7c15ULL + (aHash << 6) + (aHash >> 2);
+    return aHash;
+  }
+
+  inline uint64_t mix(uint64_t aHash, llvm::StringRef aBytes) {
+    uint64_t fnv = 0xcbf29ce484222325ULL;
+    for (unsigned char c : aBytes) {
+      fnv = (fnv ^ c) * 0x100000001b3ULL;
+    }
+    return mix(aHash, fnv);
+  }
+
+  // Stable structural hash of a function body. It covers everything the
+  // numbering reads: opcodes, types, flags, predicates, PHI incoming blocks and
+  // the operand graph. Operands that are not local to the function are encoded
+  // by content and by order of first occurrence, so the identity relations
+  // between them (which is all pointer-based numbering sees) are captured
+  // exactly even where content hashing is coarse. Function and parameter
+  // attributes and the types of globals are covered too, as alias analysis
+  // reads them when numbering with MemorySSA.
+  //
+  // Hashes of constants and types are memoized by address. Use one hasher per
+  // module, and never after the context that owns the values it has hashed is
+  // destroyed, since a new context may reuse their addresses.
+  class StructuralHasher {
+  public:
+    uint64_t hash(const llvm::Function& aFunction) {
+      fLocals.clear();
+      fOccurrences.clear();
+      uint64_t next = 0;
+      for (auto& bb : aFunction) {
+        fLocals[&bb] = next++;
+        for (auto& inst : bb) {
+          fLocals[&inst] = next++;
+        }
+      }
+
+      uint64_t hash = mix(FORMAT_VERSION, hashType(aFunction.getFunctionType()));
+      auto attributes = aFunction.getAttributes();
+      hash = mix(hash, attributes.getFnAttrs().getAsString());
+      hash = mix(hash, attributes.getRetAttrs().getAsString());
+      for (unsigned i = 0; i != aFunction.arg_size(); ++i) {
+        hash = mix(hash, attributes.getParamAttrs(i).getAsString());
+      }
+      for (auto& bb : aFunction) {
+        hash = mix(hash, bb.size());
+        for (auto& inst : bb) {
+          hash = mix(hash, hashInstruction(inst));
+        }
+      }
+      return hash;
+    }
+
+  private:
+    uint64_t hashInstruction(const llvm::Instruction& aInst) {
+      uint64_t hash = mix(aInst.getOpcode(), hashType(aInst.getType()));
+      hash = mix(hash, aInst.getRawSubclassOptionalData());
+      if (auto* cmp = llvm::dyn_cast<llvm::CmpInst>(&aInst)) {
+        hash = mix(hash, cmp->getPredicate());
+      }
+      hash = mix(hash, aInst.getNumOperands());
+      for (auto* operand : aInst.operand_values()) {
+        hash = mix(hash, hashOperand(operand));
+      }
+      if (auto* phi = llvm::dyn_cast<llvm::PHINode>(&aInst)) {
+        for (auto* block : phi->blocks()) {
+          hash = mix(hash, hashOperand(block));
+        }
+      }
+      return hash;
+    }
+
+    uint64_t hashOperand(const llvm::Value* aValue) {
+      auto local = fLocals.find(aValue);
+      if (local != fLocals.end()) {
+        return mix(1, local->second);
+      }
+      if (auto* arg = llvm::dyn_cast<llvm::Argument>(aValue)) {
+        return mix(2, arg->getArgNo());
+      }
+      auto occurrence =
+          fOccurrences.try_emplace(aValue, fOccurrences.size()).first->second;
+      uint64_t content = 0;
+      if (auto* constant = llvm::dyn_cast<llvm::Constant>(aValue)) {
+        content = hashConstant(constant);
+      }
+      return mix(mix(3, occurrence), content);
+    }
+
+    uint64_t hashConstant(const llvm::Constant* aConstant) {
+      auto cached = fConstants.find(aConstant);
+      if (cached != fConstants.end()) {
+        return cached->second;
+      }
+      uint64_t hash =
+          mix(aConstant->getValueID(), hashType(aConstant->getType()));
+      if (auto* global = llvm::dyn_cast<llvm::GlobalValue>(aConstant)) {
+        hash = mix(hash, global->getName());
+        hash = mix(hash, hashType(global->getValueType()));
+      } else if (auto* integer = llvm::dyn_cast<llvm::ConstantInt>(aConstant)) {
+        hash = mix(hash, hashBits(integer->getValue()));
+      } else if (auto* fp = llvm::dyn_cast<llvm::ConstantFP>(aConstant)) {
+        hash = mix(hash, hashBits(fp->getValueAPF().bitcastToAPInt()));
+      } else if (auto* data =
+                     llvm::dyn_cast<llvm::ConstantDataSequential>(aConstant)) {
+        hash = mix(hash, data->getRawDataValues());
+      } else {
+        if (auto* expr = llvm::dyn_cast<llvm::ConstantExpr>(aConstant)) {
+          hash = mix(hash, expr->getOpcode());
+        }
+        for (auto* operand : aConstant->operand_values()) {
+          auto* nested = llvm::dyn_cast<llvm::Constant>(operand);
+          hash = mix(hash, nested ? hashConstant(nested) : 0);
+        }
+      }
+      fConstants[aConstant] = hash;
+      return hash;
+    }
+
+    static uint64_t hashBits(const llvm::APInt& aBits) {
+      uint64_t hash = aBits.getBitWidth();
+      for (unsigned i = 0; i != aBits.getNumWords(); ++i) {
+        hash = mix(hash, aBits.getRawData()[i]);
+      }
+      return hash;
+    }
+
+    uint64_t hashType(llvm::Type* aType) {
+      auto cached = fTypes.find(aType);
+      if (cached != fTypes.end()) {
+        return cached->second;
+      }
+      uint64_t hash = mix(aType->getTypeID(), 0);
+      if (auto* integer = llvm::dyn_cast<llvm::IntegerType>(aType)) {
+        hash = mix(hash, integer->getBitWidth());
+      } else if (auto* pointer = llvm::dyn_cast<llvm::PointerType>(aType)) {
+        hash = mix(hash, pointer->getAddressSpace());
+      } else if (auto* array = llvm::dyn_cast<llvm::ArrayType>(aType)) {
+        hash = mix(hash, array->getNumElements());
+      } else if (auto* vector = llvm::dyn_cast<llvm::VectorType>(aType)) {
+        hash = mix(hash, vector->getElementCount().getKnownMinValue());
+        hash = mix(hash, vector->getElementCount().isScalable());
+      }
+      // Named structs are identified by name; recursing could loop
+      auto* structType = llvm::dyn_cast<llvm::StructType>(aType);
+      if (structType && structType->hasName()) {
+        hash = mix(hash, structType->getName());
+      } else {
+        for (auto* contained : aType->subtypes()) {
+          hash = mix(hash, hashType(contained));
+        }
+      }
+      fTypes[aType] = hash;
+      return hash;
+    }
+
+    llvm::DenseMap<const llvm::Value*, uint64_t> fLocals;
+    llvm::DenseMap<const llvm::Value*, uint64_t> fOccurrences;
+    llvm::DenseMap<const llvm::Constant*, uint64_t> fConstants;
+    llvm::DenseMap<llvm::Type*, uint64_t> fTypes;
+  };
+
+  // Cache key: the structural hash qualified by every option of aVN that
+  // changes the classes. With MemorySSA, alias analysis also depends on the
+  // module's data layout.
+  inline uint64_t key(uint64_t aStructuralHash,
+                      const LLVMValueNumbering& aVN,
+                      const llvm::Function& aFunction) {
+    uint64_t key = mix(aStructuralHash, static_cast<uint64_t>(aVN.cycleMode()));
+    key = mix(key, aVN.positionalArguments());
+    key = mix(key, aVN.usesMemorySSA());
+    if (aVN.usesMemorySSA()) {
+      key = mix(key, aFunction.getParent()->getDataLayoutStr());
+    }
+    return key;
+  }
+
+  // Dense class id per instruction of aFunction, in layout order
+  inline std::vector<uint32_t> classesOf(LLVMValueNumbering& aVN,
+                                         llvm::Function& aFunction) {
+    std::unordered_map<LLVMValueNumbering::ValueNumber, uint32_t> ids;
+    std::vector<uint32_t> classes;
+    for (auto& bb : aFunction) {
+      for (auto& inst : bb) {
+        auto vn = aVN.getValueNumber(&inst);
+        classes.push_back(ids.try_emplace(vn, ids.size()).first->second);
+      }
+    }
+    return classes;
+  }
+
+  // Seed aVN with cached classes instead of numbering aFunction. The restored
+  // numbers are qualified by the function, like argument numbers are, so they
+  // never collide with another function's classes: the numbering becomes
+  // function-local.
+  inline void restore(LLVMValueNumbering& aVN,
+                      llvm::Function& aFunction,
+                      const std::vector<uint32_t>& aClasses) {
+    size_t index = 0;
+    for (auto& bb : aFunction) {
+      for (auto& inst : bb) {
+        aVN.restoreValueNumber(
+            &inst,
+            static_cast<LLVMValueNumbering::ValueNumber>(llvm::hash_combine(
+                reinterpret_cast<uintptr_t>(&aFunction), aClasses[index++])));
+      }
+    }
+  }
+
+  inline size_t instructionCount(const llvm::Function& aFunction) {
+    size_t count = 0;
+    for (auto& bb : aFunction) {
+      count += bb.size();
+    }
+    return count;
+  }
+
+  // One file per key in a directory. The files are raw host-endian arrays and
+  // are only meant to be shared between runs on the same build host. I/O
+  // failures are treated as misses: the caller simply numbers the function.
+  class Cache {
+  public:
+    explicit Cache(std::filesystem::path aDirectory)
+        : fDirectory(std::move(aDirectory)) {
+      std::error_code ignored;
+      std::filesystem::create_directories(fDirectory, ignored);
+    }
+
+    std::optional<std::vector<uint32_t>> lookup(uint64_t aKey,
+                                                size_t aCount) const {
+      std::ifstream in(pathFor(aKey), std::ios::binary);
+      Header header{};
+      if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+          header.magic != MAGIC || header.version != FORMAT_VERSION ||
+          header.key != aKey || header.count != aCount) {
+        return {};
+      }
+      std::vector<uint32_t> classes(aCount);
+      if (!in.read(reinterpret_cast<char*>(classes.data()),
+                   aCount * sizeof(uint32_t))) {
+        return {};
+      }
+      return classes;
+    }
+
+    // Written to a uniquely named temporary file and renamed, so concurrent
+    // builds never observe a partial entry.
+    bool insert(uint64_t aKey, const std::vector<uint32_t>& aClasses) const {
+      auto path = pathFor(aKey);
+      auto temporary = path;
+      temporary += "." + std::to_string(std::random_device{}()) + ".tmp";
+      {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        Header header{MAGIC, FORMAT_VERSION, aKey, aClasses.size()};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(aClasses.data()),
+                  aClasses.size() * sizeof(uint32_t));
+        if (!out) {
+          return false;
+        }
+      }
+      std::error_code error;
+      std::filesystem::rename(temporary, path, error);
+      if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+      }
+      return true;
+    }
+
+  private:
+    struct Header {
+      uint32_t magic;
+      uint32_t version;
+      uint64_t key;
+      uint64_t count;
+    };
+
+    std::filesystem::path pathFor(uint64_t aKey) const {
+      char name[32];
+      std::snprintf(name, sizeof(name), "%016llx.vnc",
+                    static_cast<unsigned long long>(aKey));
+      return fDirectory / name;
+    }
+
+    std::filesystem::path fDirectory;
+  };
+
+  // Numbers aFunction through aCache: reloads its classes on a hit, and on a
+  // miss numbers it and stores them. Either way the classes are then
+  // restore()d, so aVN holds the same function-local numbering whether the
+  // cache was cold or warm. Returns whether it was a hit.
+  inline bool numberFunction(LLVMValueNumbering& aVN,
+                             llvm::Function& aFunction,
+                             StructuralHasher& aHasher,
+                             const Cache& aCache) {
+    uint64_t cacheKey = key(aHasher.hash(aFunction), aVN, aFunction);
+    auto classes = aCache.lookup(cacheKey, instructionCount(aFunction));
+    bool hit = classes.has_value();
+    if (!hit) {
+      classes = classesOf(aVN, aFunction);
+      aCache.insert(cacheKey, *classes);
+    }
+    restore(aVN, aFunction, *classes);
+    return hit;
+  }
+} // namespace VNCache
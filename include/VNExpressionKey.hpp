@@ -0,0 +1,79 @@
+#pragma once
+
+#include <llvm/ADT/SmallVector.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Flat expression keys for LLVMValueNumbering.
+//
+// An instruction's key is a contiguous array of 64-bit words: a header word
+// (opcode, result type and predicate) followed by the operand value numbers and, with MemorySSA, a
+// memory-state word. Up to InlineWords words live inline; longer keys (calls,
+// PHIs, GEPs with many indices) spill to the heap. The whole array is hashed
+// once, with four independent lanes whose multiplies overlap in the
+// pipeline, instead of folding one operand at a time through hash_combine.
+namespace VNExpressionKey {
+  constexpr unsigned InlineWords = 8;
+
+  using Words = llvm::SmallVector<uint64_t, InlineWords>;
+
+  constexpr uint64_t LANE_MULTIPLIERS[4] = {
+      0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL,
+      0x165667b19e3779f9ULL, 0xd6e8feb86659fd93ULL};
+
+  inline uint64_t rotl(uint64_t aValue, unsigned aShift) {
+    return (aValue << aShift) | (aValue >> (64 - aShift));
+  }
+
+  inline uint64_t avalanche(uint64_t aHash) {
+    aHash ^= aHash >> 33;
+    aHash *= 0xff51afd7ed558ccdULL;
+    aHash ^= aHash >> 33;
+    aHash *= 0xc4ceb9fe1a85ec53ULL;
+    aHash ^= aHash >> 33;
+    return aHash;
+  }
+
+  // Header word of the fields of an instruction that are not operands: its
+  // opcode, the identity of its result type and its predicate (0 if none).
+  // The opcode fills the high 32 bits and the predicate the low 32 bits of a
+  // word xored with the mixed type, so only the type needs mixing.
+  inline uint64_t header(uint32_t aOpcode, uint64_t aType, uint32_t aPredicate) {
+    return avalanche(aType) ^ (static_cast<uint64_t>(aOpcode) << 32 | aPredicate);
+  }
+
+  // Word i feeds lane i % 4. The lanes have no dependency on each other, so
+  // the four multiplies of a step issue back to back rather than waiting on
+  // each other. They are scalar: x86 has no vector 64-bit multiply before
+  // AVX-512DQ.
+  inline uint64_t hash(const uint64_t* aWords, size_t aCount) {
+    uint64_t lanes[4] = {LANE_MULTIPLIERS[0], LANE_MULTIPLIERS[1],
+                         LANE_MULTIPLIERS[2], LANE_MULTIPLIERS[3]};
+    size_t i = 0;
+    for (; i + 4 <= aCount; i += 4) {
+      for (unsigned lane = 0; lane != 4; ++lane) {
+        lanes[lane] = rotl((lanes[lane] ^ aWords[i + lane]) * LANE_MULTIPLIERS[lane], 31);
+      }
+    }
+    for (unsigned lane = 0; i != aCount; ++i, ++lane) {
+      lanes[lane] = rotl((lanes[lane] ^ aWords[i]) * LANE_MULTIPLIERS[lane], 31);
+    }
+    // The length keeps keys that differ only by trailing zero words apart
+    return avalanche(rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) +
+                     rotl(lanes[3], 18) + aCount);
+  }
+
+  inline uint64_t hash(const Words& aWords) {
+    return hash(aWords.data(), aWords.size());
+  }
+
+  // Canonical order of the two operands of a commutative operation. min/max
+  // compile to conditional moves, not a branch on the (random) numbers.
+  inline void sortPair(uint64_t& aFirst, uint64_t& aSecond) {
+    uint64_t low = std::min(aFirst, aSecond);
+    uint64_t high = std::max(aFirst, aSecond);
+    aFirst = low;
+    aSecond = high;
+  }
+} // namespace VNExpressionKey
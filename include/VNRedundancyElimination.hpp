@@ -0,0 +1,175 @@
+#pragma once
+
+#include "LLVMValueNumbering.hpp"
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Analysis/MemorySSA.h>
+#include <llvm/Analysis/MemorySSAUpdater.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/InstrTypes.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Pass.h>
+#include <llvm/Transforms/Utils/Local.h>
+#include <utility>
+
+// Cheap redundancy elimination (CSE) built on LLVMValueNumbering.
+//
+// The dominator tree is walked in preorder with LLVMValueNumbering's scoped
+// leader table, so the leader available for an instruction's value number is
+// a single lookup. An instruction is redundant when that leader computes the
+// same operation on the same (leader) operands. All redundant instructions are
+// replaced by their leaders and erased.
+//
+// The value numbers only select candidates. They ignore predicates and types,
+// so equality is always confirmed structurally before an instruction is
+// replaced. Loads and read-only calls are only considered when MemorySSA is
+// available; they are then also required to see the same clobbering access.
+namespace VNRedundancyElimination {
+  using LeaderMap = llvm::DenseMap<llvm::Value*, llvm::Value*>;
+
+  // Only pure, non-PHI computations may be replaced, plus simple loads and
+  // read-only calls when aMemoryAware. Side-effecting instructions, PHIs,
+  // allocas and freezes are never candidates.
+  inline bool isCandidate(const llvm::Instruction& aInst, bool aMemoryAware) {
+    if (aInst.getType()->isVoidTy() || aInst.getType()->isTokenTy() ||
+        aInst.isTerminator() || aInst.isEHPad()) {
+      return false;
+    }
+    if (llvm::isa<llvm::PHINode>(aInst) || llvm::isa<llvm::AllocaInst>(aInst) ||
+        llvm::isa<llvm::FreezeInst>(aInst)) {
+      return false;
+    }
+    if (auto* load = llvm::dyn_cast<llvm::LoadInst>(&aInst)) {
+      return aMemoryAware && load->isSimple();
+    }
+    if (auto* call = llvm::dyn_cast<llvm::CallBase>(&aInst)) {
+      bool readsAllowed = aMemoryAware ? call->onlyReadsMemory()
+                                       : call->doesNotAccessMemory();
+      return readsAllowed && !call->isConvergent() && call->willReturn();
+    }
+    return !aInst.mayHaveSideEffects() && !aInst.mayReadFromMemory();
+  }
+
+  inline bool haveSameMemoryState(llvm::Instruction& aInst,
+                                  llvm::Instruction& aLeader,
+                                  llvm::MemorySSA* aMemorySSA) {
+    if (!aInst.mayReadFromMemory()) {
+      return true;
+    }
+    if (!aMemorySSA) {
+      return false;
+    }
+    auto* walker = aMemorySSA->getWalker();
+    return walker->getClobberingMemoryAccess(&aInst) ==
+           walker->getClobberingMemoryAccess(&aLeader);
+  }
+
+  inline llvm::Value* leaderOf(llvm::Value* aValue, const LeaderMap& aLeaders) {
+    auto it = aLeaders.find(aValue);
+    return it == aLeaders.end() ? aValue : it->second;
+  }
+
+  // Operands are compared through their leaders, so a chain of redundant
+  // expressions is recognised before any of it has been rewritten.
+  inline bool haveSameOperands(const llvm::Instruction& aInst,
+                               const llvm::Instruction& aLeader,
+                               const LeaderMap& aLeaders) {
+    auto same = [&](unsigned aLhs, unsigned aRhs) {
+      return leaderOf(aInst.getOperand(aLhs), aLeaders) ==
+             leaderOf(aLeader.getOperand(aRhs), aLeaders);
+    };
+    bool inOrder = true;
+    for (unsigned i = 0, e = aInst.getNumOperands(); i != e && inOrder; ++i) {
+      inOrder = same(i, i);
+    }
+    if (inOrder) {
+      return true;
+    }
+    return llvm::isa<llvm::BinaryOperator>(aInst) && aInst.isCommutative() &&
+           same(0, 1) && same(1, 0);
+  }
+
+  // Returns the number of instructions erased from the function of aDomTree.
+  // With aMemorySSA, redundant loads are eliminated too and MemorySSA is kept
+  // up to date.
+  inline unsigned run(const llvm::DominatorTree& aDomTree,
+                      llvm::MemorySSA* aMemorySSA = nullptr) {
+    LLVMValueNumbering vn;
+    vn.setMemorySSA(aMemorySSA);
+    LeaderMap leaders;
+    llvm::SmallVector<std::pair<llvm::Instruction*, llvm::Instruction*>, 32>
+        replacements;
+    vn.forEachInDominatorScope(aDomTree, [&](llvm::Instruction& aInst) {
+      if (!isCandidate(aInst, aMemorySSA != nullptr)) {
+        return;
+      }
+      auto number = vn.getValueNumber(&aInst);
+      auto* leader = vn.availableLeader(number);
+      if (leader &&
+          leader->isSameOperationAs(
+              &aInst, llvm::Instruction::CompareIgnoringAlignment) &&
+          haveSameOperands(aInst, *leader, leaders) &&
+          haveSameMemoryState(aInst, *leader, aMemorySSA)) {
+        leaders[&aInst] = leader;
+        replacements.emplace_back(&aInst, leader);
+        return;
+      }
+      // Either the first of its class on this path or a false congruence;
+      // in both cases it is the leader for the blocks it dominates.
+      vn.publishLeader(number, &aInst);
+    });
+
+    // Replace everything before erasing so that redundant users of redundant
+    // instructions never see a dangling operand. The leader keeps only the
+    // poison-generating flags and metadata that hold for both.
+    for (auto& [inst, leader] : replacements) {
+      leader->andIRFlags(inst);
+      llvm::combineMetadataForCSE(leader, inst, false);
+      inst->replaceAllUsesWith(leader);
+    }
+    for (auto& [inst, leader] : replacements) {
+      if (aMemorySSA) {
+        llvm::MemorySSAUpdater(aMemorySSA).removeMemoryAccess(inst);
+      }
+      inst->eraseFromParent();
+    }
+    return replacements.size();
+  }
+
+  // Legacy pass manager wrapper, so that the elimination can be scheduled and
+  // timed next to createGVNPass() in tPasses.
+  class Pass : public llvm::FunctionPass {
+  public:
+    static inline char ID = 0;
+
+    Pass() : llvm::FunctionPass(ID) {
+    }
+
+    bool runOnFunction(llvm::Function& aFunction) override {
+      if (skipFunction(aFunction)) {
+        return false;
+      }
+      auto& domTree =
+          getAnalysis<llvm::DominatorTreeWrapperPass>().getDomTree();
+      auto& memorySSA = getAnalysis<llvm::MemorySSAWrapperPass>().getMSSA();
+      return run(domTree, &memorySSA) != 0;
+    }
+
+    void getAnalysisUsage(llvm::AnalysisUsage& aUsage) const override {
+      aUsage.addRequired<llvm::DominatorTreeWrapperPass>();
+      aUsage.addRequired<llvm::MemorySSAWrapperPass>();
+      aUsage.addPreserved<llvm::MemorySSAWrapperPass>();
+      aUsage.setPreservesCFG();
+    }
+
+    llvm::StringRef getPassName() const override {
+      return "VN Redundancy Elimination";
+    }
+  };
+} // namespace VNRedundancyElimination
+
+inline llvm::FunctionPass* createVNRedundancyEliminationPass() {
+  return new VNRedundancyElimination::Pass();
+}
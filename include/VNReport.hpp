@@ -0,0 +1,162 @@
+#pragma once
+
+#include "LLVMValueNumbering.hpp"
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/Function.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Machine-readable congruence reports.
+//
+// A report is built per function, so functions can be summarized in parallel
+// (one LLVMValueNumbering per task), and then written in module order in
+// one of two formats:
+//  - JSON, streamed with llvm::json::OStream (no DOM is built);
+//  - a compact little-endian binary layout for bulk collection.
+// Both are written to a raw_ostream; give it a large buffer (or use
+// raw_fd_ostream, which buffers) rather than flushing per line.
+namespace VNReport {
+  constexpr uint32_t MAGIC = 0x5256574d; // "MWVR"
+  constexpr uint32_t FORMAT_VERSION = 1;
+
+  struct FunctionReport {
+    std::string name;
+    uint32_t classes = 0;         // Distinct value numbers
+    uint32_t candidateGroups = 0; // Classes with more than one instruction
+    std::vector<uint32_t> classOf; // Dense class id per instruction, layout order
+
+    uint32_t instructions() const {
+      return static_cast<uint32_t>(classOf.size());
+    }
+    // All instructions but one per class are redundant
+    uint32_t redundant() const {
+      return instructions() - classes;
+    }
+  };
+
+  struct Summary {
+    uint64_t functions = 0;
+    uint64_t instructions = 0;
+    uint64_t classes = 0;
+    uint64_t candidateGroups = 0;
+    uint64_t redundant = 0;
+
+    void add(const FunctionReport& aReport) {
+      ++functions;
+      instructions += aReport.instructions();
+      classes += aReport.classes;
+      candidateGroups += aReport.candidateGroups;
+      redundant += aReport.redundant();
+    }
+  };
+
+  // Numbers aFunction with aVN (which the caller clears or seeds beforehand)
+  inline FunctionReport summarize(llvm::Function& aFunction,
+                                  LLVMValueNumbering& aVN) {
+    FunctionReport report;
+    report.name = aFunction.getName().str();
+    std::unordered_map<LLVMValueNumbering::ValueNumber, uint32_t> ids;
+    std::vector<uint32_t> sizes;
+    for (auto& bb : aFunction) {
+      for (auto& inst : bb) {
+        auto [it, inserted] = ids.try_emplace(aVN.getValueNumber(&inst),
+                                              static_cast<uint32_t>(ids.size()));
+        if (inserted) {
+          sizes.push_back(0);
+        }
+        if (++sizes[it->second] == 2) {
+          ++report.candidateGroups;
+        }
+        report.classOf.push_back(it->second);
+      }
+    }
+    report.classes = static_cast<uint32_t>(ids.size());
+    return report;
+  }
+
+  // Spelled out because the llvm::support endianness names changed between
+  // LLVM releases
+  template <typename T>
+  inline void writeLittleEndian(llvm::raw_ostream& aOut, T aValue) {
+    char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      bytes[i] = static_cast<char>(static_cast<uint64_t>(aValue) >> (8 * i));
+    }
+    aOut.write(bytes, sizeof(T));
+  }
+
+  inline Summary summaryOf(const std::vector<FunctionReport>& aReports) {
+    Summary summary;
+    for (auto& report : aReports) {
+      summary.add(report);
+    }
+    return summary;
+  }
+
+  inline void writeJSON(llvm::raw_ostream& aOut,
+                        llvm::StringRef aModule,
+                        const std::vector<FunctionReport>& aReports) {
+    auto summary = summaryOf(aReports);
+    llvm::json::OStream json(aOut);
+    json.object([&] {
+      json.attribute("version", FORMAT_VERSION);
+      json.attribute("module", aModule);
+      json.attributeObject("summary", [&] {
+        json.attribute("functions", summary.functions);
+        json.attribute("instructions", summary.instructions);
+        json.attribute("uniqueValueNumbers", summary.classes);
+        json.attribute("candidateGroups", summary.candidateGroups);
+        json.attribute("redundantInstructions", summary.redundant);
+      });
+      json.attributeArray("functions", [&] {
+        for (auto& report : aReports) {
+          json.object([&] {
+            json.attribute("name", report.name);
+            json.attribute("instructions", report.instructions());
+            json.attribute("uniqueValueNumbers", report.classes);
+            json.attribute("candidateGroups", report.candidateGroups);
+            json.attribute("redundantInstructions", report.redundant());
+            json.attributeArray("classOf", [&] {
+              for (auto id : report.classOf) {
+                json.value(id);
+              }
+            });
+          });
+        }
+      });
+    });
+    aOut << "\n";
+  }
+
+  // Layout, all integers little-endian:
+  //   u32 magic, u32 version, u64 x 5 summary counts (functions,
+  //   instructions, classes, candidate groups, redundant)
+  //   per function: u32 name length, name bytes, u32 instructions,
+  //   u32 classes, u32 candidate groups, u32 class id per instruction
+  inline void writeBinary(llvm::raw_ostream& aOut,
+                          const std::vector<FunctionReport>& aReports) {
+    auto summary = summaryOf(aReports);
+    writeLittleEndian<uint32_t>(aOut, MAGIC);
+    writeLittleEndian<uint32_t>(aOut, FORMAT_VERSION);
+    writeLittleEndian<uint64_t>(aOut, summary.functions);
+    writeLittleEndian<uint64_t>(aOut, summary.instructions);
+    writeLittleEndian<uint64_t>(aOut, summary.classes);
+    writeLittleEndian<uint64_t>(aOut, summary.candidateGroups);
+    writeLittleEndian<uint64_t>(aOut, summary.redundant);
+    for (auto& report : aReports) {
+      writeLittleEndian<uint32_t>(aOut, static_cast<uint32_t>(report.name.size()));
+      aOut << report.name;
+      writeLittleEndian<uint32_t>(aOut, report.instructions());
+      writeLittleEndian<uint32_t>(aOut, report.classes);
+      writeLittleEndian<uint32_t>(aOut, report.candidateGroups);
+      for (auto id : report.classOf) {
+        writeLittleEndian<uint32_t>(aOut, id);
+      }
+    }
+  }
+} // namespace VNReport
@@ -0,0 +1,197 @@
+#pragma once
+
+// Hot-path statistics and tracing for LLVMValueNumbering.
+//
+// Compiled in only with -DMW_VN_STATS=1 (CMake: -DMW_VN_STATS=ON). Otherwise
+// MW_VN_STAT(...) expands to nothing and LLVMValueNumbering has neither the
+// member nor the calls, so the instrumentation costs nothing at all.
+#ifndef MW_VN_STATS
+#define MW_VN_STATS 0
+#endif
+
+#if MW_VN_STATS
+
+#include <llvm/IR/Instruction.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define MW_VN_STAT(...) __VA_ARGS__
+
+namespace VNStats {
+  using Clock = std::chrono::steady_clock;
+
+  class Stats {
+  public:
+    Stats() : fEpoch(Clock::now()) {
+    }
+
+    void hit() {
+      ++fHits;
+    }
+    void miss() {
+      ++fMisses;
+    }
+    // A temporary value number was issued to break a recursion cycle
+    void cycleBreak() {
+      ++fCycleBreaks;
+    }
+    // A new member was given the number of a different operation
+    void collision() {
+      ++fCollisions;
+    }
+    void depth(size_t aDepth) {
+      fMaxDepth = std::max(fMaxDepth, aDepth);
+    }
+
+    // Record up to aLimit trace events from now on; 0 turns tracing off
+    void enableTrace(size_t aLimit) {
+      fTraceLimit = aLimit;
+      fTrace.clear();
+      fTrace.reserve(std::min<size_t>(aLimit, 1 << 16));
+    }
+
+    // Timing of one instruction's numbering. Operands numbered on the way are
+    // nested frames; their time is subtracted to give per-opcode self time.
+    void begin() {
+      fFrames.push_back({Clock::now(), 0});
+      depth(fFrames.size());
+    }
+
+    void end(unsigned aOpcode) {
+      auto frame = fFrames.back();
+      fFrames.pop_back();
+      int64_t total = nanoseconds(Clock::now() - frame.start);
+      if (!fFrames.empty()) {
+        fFrames.back().childNs += total;
+      }
+      if (aOpcode < fCount.size()) {
+        ++fCount[aOpcode];
+        fSelfNs[aOpcode] += total - frame.childNs;
+      }
+      if (fTrace.size() < fTraceLimit) {
+        fTrace.push_back({aOpcode, nanoseconds(frame.start - fEpoch), total});
+      }
+    }
+
+    // aEmit(name, value) for every fixed counter, zero or not, so they are
+    // stable benchmark columns, then an n. and ns. pair for every opcode
+    // numbered at least once. Counts are totals since the last reset(),
+    // except max_depth which is a maximum.
+    template <typename Emit>
+    void forEachCounter(Emit&& aEmit) const {
+      aEmit("table_hits", static_cast<double>(fHits));
+      aEmit("table_misses", static_cast<double>(fMisses));
+      aEmit("cycle_breaks", static_cast<double>(fCycleBreaks));
+      aEmit("collisions", static_cast<double>(fCollisions));
+      aEmit("max_depth", static_cast<double>(fMaxDepth));
+      for (unsigned opcode = 0; opcode != fCount.size(); ++opcode) {
+        if (fCount[opcode] == 0) {
+          continue;
+        }
+        std::string name = llvm::Instruction::getOpcodeName(opcode);
+        aEmit("n." + name, static_cast<double>(fCount[opcode]));
+        aEmit("ns." + name, static_cast<double>(fSelfNs[opcode]));
+      }
+    }
+
+    // Chrome trace-event format (chrome://tracing, Perfetto): one complete
+    // event per numbered instruction, nested by operand chains
+    void writeChromeTrace(llvm::raw_ostream& aOut) const {
+      llvm::json::OStream json(aOut);
+      json.object([&] {
+        json.attribute("displayTimeUnit", "ns");
+        json.attributeArray("traceEvents", [&] {
+          for (auto& event : fTrace) {
+            json.object([&] {
+              json.attribute("name", llvm::Instruction::getOpcodeName(event.opcode));
+              json.attribute("cat", "vn");
+              json.attribute("ph", "X");
+              json.attribute("ts", event.startNs / 1e3);
+              json.attribute("dur", event.durationNs / 1e3);
+              json.attribute("pid", 0);
+              json.attribute("tid", 0);
+            });
+          }
+        });
+      });
+      aOut << "\n";
+    }
+
+    void reset() {
+      *this = Stats();
+    }
+
+    uint64_t hits() const {
+      return fHits;
+    }
+    uint64_t misses() const {
+      return fMisses;
+    }
+    uint64_t cycleBreaks() const {
+      return fCycleBreaks;
+    }
+    uint64_t collisions() const {
+      return fCollisions;
+    }
+    size_t maxDepth() const {
+      return fMaxDepth;
+    }
+
+  private:
+    struct Frame {
+      Clock::time_point start;
+      int64_t childNs;
+    };
+
+    struct TraceEvent {
+      unsigned opcode;
+      int64_t startNs;
+      int64_t durationNs;
+    };
+
+    static int64_t nanoseconds(Clock::duration aDuration) {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(aDuration).count();
+    }
+
+    Clock::time_point fEpoch;
+    uint64_t fHits = 0;
+    uint64_t fMisses = 0;
+    uint64_t fCycleBreaks = 0;
+    uint64_t fCollisions = 0;
+    size_t fMaxDepth = 0;
+    std::array<uint64_t, llvm::Instruction::OtherOpsEnd> fCount{};
+    std::array<int64_t, llvm::Instruction::OtherOpsEnd> fSelfNs{};
+    std::vector<Frame> fFrames;
+    size_t fTraceLimit = 0;
+    std::vector<TraceEvent> fTrace;
+  };
+
+  // Times the enclosing scope as the numbering of one aOpcode instruction
+  class Scope {
+  public:
+    Scope(Stats& aStats, unsigned aOpcode) : fStats(aStats), fOpcode(aOpcode) {
+      fStats.begin();
+    }
+    ~Scope() {
+      fStats.end(fOpcode);
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    Stats& fStats;
+    unsigned fOpcode;
+  };
+} // namespace VNStats
+
+#else
+
+#define MW_VN_STAT(...)
+
+#endif
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <llvm/ADT/Twine.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SourceMgr.h>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+// Bounded-memory traversal of large bitcode files.
+//
+// The module is loaded lazily: only globals and function prototypes are read
+// up front. Each function body is materialized right before it is visited and
+// deleted right after, so peak memory follows the largest function rather
+// than the module. Textual IR cannot be loaded lazily and is parsed whole;
+// the traversal then only saves the memory of the bodies already visited.
+namespace VNStreaming {
+  struct Summary {
+    size_t functions = 0;
+    size_t instructions = 0;
+    size_t largestFunction = 0; // In instructions
+  };
+
+  // Calls aVisit(llvm::Function&) for every function defined in aPath, in
+  // module order, with only that body materialized. With aMemoryMap the file
+  // is mapped instead of read into the heap, and the kernel pages the parts
+  // of the bitcode that are still needed. Returns false and fills aError if
+  // the file cannot be read or a body fails to load.
+  //
+  // The visitor must not keep pointers into a body after it returns.
+  template <typename Visit>
+  bool forEachFunction(const llvm::Twine& aPath,
+                       llvm::LLVMContext& aContext,
+                       bool aMemoryMap,
+                       Visit&& aVisit,
+                       Summary& aSummary,
+                       llvm::SMDiagnostic& aError) {
+    auto buffer = llvm::MemoryBuffer::getFile(aPath, /*IsText=*/false,
+                                              /*RequiresNullTerminator=*/true,
+                                              /*IsVolatile=*/!aMemoryMap);
+    if (!buffer) {
+      aError = llvm::SMDiagnostic(aPath.str(), llvm::SourceMgr::DK_Error,
+                                  "Could not open input file: " +
+                                      buffer.getError().message());
+      return false;
+    }
+    auto module = llvm::getLazyIRModule(std::move(*buffer), aError, aContext,
+                                        /*ShouldLazyLoadMetadata=*/true);
+    if (!module) {
+      return false;
+    }
+
+    for (auto& function : *module) {
+      if (auto error = function.materialize()) {
+        aError = llvm::SMDiagnostic(aPath.str(), llvm::SourceMgr::DK_Error,
+                                    llvm::toString(std::move(error)));
+        return false;
+      }
+      if (function.isDeclaration()) {
+        continue;
+      }
+
+      size_t instructions = function.getInstructionCount();
+      ++aSummary.functions;
+      aSummary.instructions += instructions;
+      aSummary.largestFunction =
+          std::max(aSummary.largestFunction, instructions);
+
+      aVisit(function);
+      // Back to a declaration: the body's instructions and blocks are freed,
+      // while calls from bodies materialized later still resolve to it
+      function.deleteBody();
+    }
+    return true;
+  }
+} // namespace VNStreaming
@@ -41,6 +41,10 @@ public:
     }
   }
 
+  void erase(T aKey) {
+    fTable.left.erase(aKey);
+  }
+
   void clear() {
     fTable.clear();
   }
@@ -0,0 +1,228 @@
+#include "../../include/LLVMValueNumbering.hpp"
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+#include <tbb/global_control.h>
+#include <tbb/parallel_for.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string> Inputs(cl::Positional, cl::OneOrMore,
+    cl::desc("<directories, .ll/.bc files, or @file-lists>"));
+
+static cl::opt<unsigned> Jobs("jobs",
+    cl::desc("Worker threads (0 = all hardware threads)"),
+    cl::init(0));
+
+static cl::opt<unsigned> Slowest("slowest",
+    cl::desc("Number of slowest files to report"),
+    cl::init(10));
+
+static cl::opt<bool> PerFile("per-file",
+    cl::desc("Print one line per file"),
+    cl::init(false));
+
+static cl::opt<bool> Optimistic("optimistic",
+    cl::desc("Number loop-carried cycles optimistically (SCC fixpoint) instead of breaking them"),
+    cl::init(false));
+
+using Clock = std::chrono::steady_clock;
+
+struct FileResult {
+    std::string path;
+    std::optional<std::string> error;
+    size_t functions = 0;
+    size_t instructions = 0;
+    double parseSeconds = 0;
+    double numberSeconds = 0;
+
+    double seconds() const {
+        return parseSeconds + numberSeconds;
+    }
+};
+
+static bool isIRFile(const std::filesystem::path& path) {
+    auto extension = path.extension();
+    return extension == ".ll" || extension == ".bc";
+}
+
+// Expand directories (recursively) and @lists (one path per line) into IR files
+static void collectInputs(const std::string& input, std::vector<std::string>& files) {
+    if (!input.empty() && input[0] == '@') {
+        std::ifstream list(input.substr(1));
+        if (!list) {
+            std::cerr << "Could not open file list " << input.substr(1) << "\n";
+        }
+        for (std::string line; std::getline(list, line);) {
+            if (!line.empty()) {
+                collectInputs(line, files);
+            }
+        }
+        return;
+    }
+
+    std::error_code error;
+    if (std::filesystem::is_directory(input, error)) {
+        for (auto& entry : std::filesystem::recursive_directory_iterator(input, error)) {
+            if (entry.is_regular_file() && isIRFile(entry.path())) {
+                files.push_back(entry.path().string());
+            }
+        }
+        return;
+    }
+    files.push_back(input);
+}
+
+// Parse and number one file. Each file gets its own context, so files share
+// no LLVM state and any number of them can be processed concurrently.
+static FileResult processFile(const std::string& path) {
+    FileResult result;
+    result.path = path;
+
+    LLVMContext context;
+    SMDiagnostic err;
+    auto start = Clock::now();
+    auto module = parseIRFile(path, err, context);
+    auto parsed = Clock::now();
+    result.parseSeconds = std::chrono::duration<double>(parsed - start).count();
+    if (!module) {
+        std::string message;
+        raw_string_ostream stream(message);
+        err.print("tCorpus", stream);
+        result.error = stream.str();
+        return result;
+    }
+
+    LLVMValueNumbering vn(Optimistic ? LLVMValueNumbering::CycleMode::Optimistic
+                                     : LLVMValueNumbering::CycleMode::Pessimistic);
+    for (auto& func : *module) {
+        if (func.isDeclaration()) {
+            continue;
+        }
+        ++result.functions;
+        for (auto& bb : func) {
+            for (auto& inst : bb) {
+                vn.getValueNumber(&inst);
+                ++result.instructions;
+            }
+        }
+    }
+    result.numberSeconds = std::chrono::duration<double>(Clock::now() - parsed).count();
+    return result;
+}
+
+static double rate(double count, double seconds) {
+    return seconds > 0 ? count / seconds : 0.0;
+}
+
+static void printRate(const char* label, double count, double seconds) {
+    std::cout << "  " << label << ": " << rate(count, seconds) << "/s\n";
+}
+
+// Instructions/s and functions/s of one file, over its numbering time and
+// over its parse and numbering time
+static void printFileRates(const FileResult& result) {
+    std::cout << "numbering " << rate(result.instructions, result.numberSeconds) << " instructions/s, "
+              << rate(result.functions, result.numberSeconds) << " functions/s; total "
+              << rate(result.instructions, result.seconds()) << " instructions/s, "
+              << rate(result.functions, result.seconds()) << " functions/s";
+}
+
+int main(int argc, char** argv) {
+    cl::ParseCommandLineOptions(argc, argv, "Parallel value numbering over a corpus of IR files\n");
+
+    std::vector<std::string> files;
+    for (auto& input : Inputs) {
+        collectInputs(input, files);
+    }
+    if (files.empty()) {
+        std::cerr << "No .ll or .bc files found\n";
+        return 1;
+    }
+
+    std::optional<tbb::global_control> threadLimit;
+    if (Jobs > 0) {
+        threadLimit.emplace(tbb::global_control::max_allowed_parallelism, Jobs);
+    }
+
+    std::vector<FileResult> results(files.size());
+    auto start = Clock::now();
+    tbb::parallel_for(size_t(0), files.size(), [&](size_t i) {
+        results[i] = processFile(files[i]);
+    });
+    double wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    size_t failed = 0;
+    size_t functions = 0;
+    size_t instructions = 0;
+    double parseSeconds = 0;
+    double numberSeconds = 0;
+    for (auto& result : results) {
+        if (result.error) {
+            ++failed;
+            std::cerr << *result.error;
+            continue;
+        }
+        functions += result.functions;
+        instructions += result.instructions;
+        parseSeconds += result.parseSeconds;
+        numberSeconds += result.numberSeconds;
+        if (PerFile) {
+            std::cout << result.path << ": " << result.functions << " functions, " << result.instructions
+                      << " instructions, parse " << result.parseSeconds * 1e3 << " ms, number "
+                      << result.numberSeconds * 1e3 << " ms, ";
+            printFileRates(result);
+            std::cout << "\n";
+        }
+    }
+
+    std::cout << "=== Corpus Summary ===\n";
+    std::cout << "Files: " << files.size() << " (" << failed << " failed)\n";
+    std::cout << "Functions: " << functions << "\n";
+    std::cout << "Instructions: " << instructions << "\n";
+    std::cout << "Wall time: " << wallSeconds * 1e3 << " ms\n";
+    std::cout << "Parse time (sum over files): " << parseSeconds * 1e3 << " ms\n";
+    std::cout << "Numbering time (sum over files): " << numberSeconds * 1e3 << " ms\n";
+    // Wall-clock rates are what a build farm sees; numbering-only rates
+    // isolate the analysis from parsing
+    std::cout << "Throughput (wall clock):\n";
+    printRate("files", files.size() - failed, wallSeconds);
+    printRate("functions", functions, wallSeconds);
+    printRate("instructions", instructions, wallSeconds);
+    std::cout << "Numbering throughput (per thread):\n";
+    printRate("functions", functions, numberSeconds);
+    printRate("instructions", instructions, numberSeconds);
+
+    std::vector<const FileResult*> slowest;
+    for (auto& result : results) {
+        if (!result.error) {
+            slowest.push_back(&result);
+        }
+    }
+    size_t shown = std::min<size_t>(Slowest, slowest.size());
+    std::partial_sort(slowest.begin(), slowest.begin() + shown, slowest.end(),
+                      [](auto* lhs, auto* rhs) { return lhs->seconds() > rhs->seconds(); });
+    std::cout << "\n=== Slowest " << shown << " Files ===\n";
+    for (size_t i = 0; i < shown; ++i) {
+        auto& result = *slowest[i];
+        std::cout << "  " << result.seconds() * 1e3 << " ms  " << result.path << " (" << result.functions
+                  << " functions, " << result.instructions << " instructions, parse " << result.parseSeconds * 1e3
+                  << " ms, ";
+        printFileRates(result);
+        std::cout << ")\n";
+    }
+
+    return failed == 0 ? 0 : 1;
+}
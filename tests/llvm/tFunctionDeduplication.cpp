@@ -0,0 +1,165 @@
+#include "../../include/FunctionDeduplication.hpp"
+#include <benchmark/benchmark.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Transforms/Utils/FunctionComparator.h>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace llvm;
+
+static cl::opt<std::string> InputFile(cl::Positional,
+    cl::desc("<input IR file (.ll or .bc)> - if not specified, uses a generated module"),
+    cl::init("-"));
+
+static cl::opt<unsigned> Shapes("shapes",
+    cl::desc("Distinct function bodies in the generated module"),
+    cl::init(64));
+
+static cl::opt<unsigned> Copies("copies",
+    cl::desc("Identical copies of each body in the generated module"),
+    cl::init(8));
+
+static cl::opt<unsigned> PairwiseLimit("pairwise-limit",
+    cl::desc("Skip the all-pairs baseline above this many functions"),
+    cl::init(5000));
+
+std::unique_ptr<LLVMContext> globalContext;
+std::unique_ptr<Module> globalModule;
+
+// Shape s is a chain of s + 1 multiply-adds over both arguments, so every
+// shape has a different body and the copies of a shape differ only in name.
+std::unique_ptr<Module> createTestModule(LLVMContext& context) {
+    auto module = std::make_unique<Module>("dedup", context);
+    auto* i32 = Type::getInt32Ty(context);
+    auto* funcType = FunctionType::get(i32, {i32, i32}, false);
+
+    for (unsigned copy = 0; copy < Copies; ++copy) {
+        for (unsigned shape = 0; shape < Shapes; ++shape) {
+            auto name = "f" + std::to_string(shape) + "_" + std::to_string(copy);
+            Function* func = Function::Create(funcType, Function::ExternalLinkage, name, module.get());
+            IRBuilder<> builder(BasicBlock::Create(context, "entry", func));
+            Value* a = func->getArg(0);
+            Value* b = func->getArg(1);
+            Value* acc = a;
+            for (unsigned i = 0; i <= shape; ++i) {
+                acc = builder.CreateAdd(builder.CreateMul(acc, b), ConstantInt::get(i32, i + 1));
+            }
+            builder.CreateRet(acc);
+        }
+    }
+    return module;
+}
+
+std::unique_ptr<Module> loadModuleFromFile(LLVMContext& context) {
+    SMDiagnostic Err;
+    auto module = parseIRFile(InputFile, Err, context);
+    if (!module) {
+        Err.print("tFunctionDeduplication", errs());
+        return nullptr;
+    }
+    return module;
+}
+
+static size_t definedFunctions(Module& module) {
+    size_t count = 0;
+    for (auto& func : module) {
+        count += !func.isDeclaration();
+    }
+    return count;
+}
+
+// Fingerprint, bucket and confirm inside buckets
+static void BM_FingerprintBuckets(benchmark::State& state) {
+    size_t groups = 0;
+    for (auto _ : state) {
+        auto duplicates = FunctionDeduplication::findDuplicates(*globalModule);
+        groups = duplicates.size();
+        benchmark::DoNotOptimize(duplicates.data());
+    }
+    state.counters["functions"] = definedFunctions(*globalModule);
+    state.counters["groups"] = groups;
+    state.SetItemsProcessed(state.iterations() * definedFunctions(*globalModule));
+}
+BENCHMARK(BM_FingerprintBuckets)->Unit(benchmark::kMillisecond);
+
+// Baseline: FunctionComparator on all pairs, the quadratic approach the
+// fingerprints replace
+static void BM_PairwiseComparison(benchmark::State& state) {
+    std::vector<Function*> functions;
+    for (auto& func : *globalModule) {
+        if (!func.isDeclaration()) {
+            functions.push_back(&func);
+        }
+    }
+    if (functions.size() > PairwiseLimit) {
+        state.SkipWithError("too many functions for the all-pairs baseline, see --pairwise-limit");
+        return;
+    }
+
+    size_t equalPairs = 0;
+    for (auto _ : state) {
+        GlobalNumberState globalNumbers;
+        equalPairs = 0;
+        for (size_t i = 0; i < functions.size(); ++i) {
+            for (size_t j = i + 1; j < functions.size(); ++j) {
+                FunctionComparator comparator(functions[i], functions[j], &globalNumbers);
+                equalPairs += comparator.compare() == 0;
+            }
+        }
+        benchmark::DoNotOptimize(equalPairs);
+    }
+    state.counters["functions"] = functions.size();
+    state.counters["equal_pairs"] = equalPairs;
+    state.SetItemsProcessed(state.iterations() * functions.size());
+}
+BENCHMARK(BM_PairwiseComparison)->Unit(benchmark::kMillisecond);
+
+void reportDuplicates(Module& module) {
+    auto duplicates = FunctionDeduplication::findDuplicates(module);
+    size_t redundant = 0;
+    for (auto& group : duplicates) {
+        redundant += group.size() - 1;
+    }
+
+    std::cout << "=== Function Deduplication ===\n";
+    std::cout << "Functions: " << definedFunctions(module) << "\n";
+    std::cout << "Duplicate groups: " << duplicates.size() << "\n";
+    std::cout << "Redundant functions: " << redundant << "\n";
+    for (auto& group : duplicates) {
+        std::cout << "  " << group.front()->getName().str() << ":";
+        for (size_t i = 1; i < group.size(); ++i) {
+            std::cout << " " << group[i]->getName().str();
+        }
+        std::cout << "\n";
+    }
+    std::cout << "\n";
+}
+
+int main(int argc, char** argv) {
+    // Benchmark flags are consumed first so that cl:: does not reject them
+    benchmark::Initialize(&argc, argv);
+    cl::ParseCommandLineOptions(argc, argv, "Identical function detection with value numbers\n");
+
+    globalContext = std::make_unique<LLVMContext>();
+    if (InputFile == "-") {
+        globalModule = createTestModule(*globalContext);
+    } else {
+        globalModule = loadModuleFromFile(*globalContext);
+        if (!globalModule) {
+            return 1;
+        }
+    }
+
+    reportDuplicates(*globalModule);
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
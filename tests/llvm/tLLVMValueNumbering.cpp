@@ -1,5 +1,15 @@
 #include "../../include/LLVMValueNumbering.hpp"
+#include "../../include/VNCache.hpp"
+#include "../../include/VNExpressionKey.hpp"
+#include "../../include/VNReport.hpp"
+#include "../../include/VNStreaming.hpp"
 #include <benchmark/benchmark.h>
+#include <llvm/Analysis/AliasAnalysis.h>
+#include <llvm/Analysis/AssumptionCache.h>
+#include <llvm/Analysis/BasicAliasAnalysis.h>
+#include <llvm/Analysis/MemorySSA.h>
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/IR/Dominators.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Function.h>
@@ -9,9 +19,15 @@
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <sys/resource.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 #include <iostream>
 #include <memory>
 #include <map>
+#include <optional>
 
 using namespace llvm;
 
@@ -63,10 +79,136 @@ std::unique_ptr<Module> createTestModule(LLVMContext& context) {
     Value* result = builder.CreateAdd(x, w, "result");
     
     builder.CreateRet(result);
-    
+
+    // Loop whose compares differ only by predicate: with --optimistic they
+    // are members of the loop's SCC, and must not be congruent, nor must the
+    // selects on them
+    //   x = phi [a, entry], [x + (select(x == 5, 1, 2) + select(x != 5, 1, 2)), loop]
+    Function* loop = Function::Create(funcType, Function::ExternalLinkage, "loop", module.get());
+    BasicBlock* entry = BasicBlock::Create(context, "entry", loop);
+    BasicBlock* body = BasicBlock::Create(context, "loop", loop);
+    BasicBlock* exit = BasicBlock::Create(context, "exit", loop);
+    Value* start = loop->getArg(0);
+    Value* limit = loop->getArg(1);
+    start->setName("a");
+    limit->setName("n");
+    IRBuilder<> loopBuilder(entry);
+    loopBuilder.CreateBr(body);
+
+    loopBuilder.SetInsertPoint(body);
+    PHINode* phi = loopBuilder.CreatePHI(Type::getInt32Ty(context), 2, "x");
+    Value* five = loopBuilder.getInt32(5);
+    Value* equal = loopBuilder.CreateICmpEQ(phi, five, "c1");
+    Value* notEqual = loopBuilder.CreateICmpNE(phi, five, "c2");
+    Value* first = loopBuilder.CreateSelect(equal, loopBuilder.getInt32(1), loopBuilder.getInt32(2), "s1");
+    Value* second = loopBuilder.CreateSelect(notEqual, loopBuilder.getInt32(1), loopBuilder.getInt32(2), "s2");
+    Value* next = loopBuilder.CreateAdd(phi, loopBuilder.CreateAdd(first, second, "sum"), "x.next");
+    phi->addIncoming(start, entry);
+    phi->addIncoming(next, body);
+    loopBuilder.CreateCondBr(loopBuilder.CreateICmpSGE(next, limit, "done"), exit, body);
+
+    loopBuilder.SetInsertPoint(exit);
+    loopBuilder.CreateRet(next);
+
     return module;
 }
 
+static cl::opt<bool> Optimistic("optimistic",
+    cl::desc("Number loop-carried cycles optimistically (SCC fixpoint) instead of breaking them"),
+    cl::init(false));
+
+static LLVMValueNumbering::CycleMode cycleMode() {
+    return Optimistic ? LLVMValueNumbering::CycleMode::Optimistic
+                      : LLVMValueNumbering::CycleMode::Pessimistic;
+}
+
+static cl::opt<bool> UseMemorySSA("memory-ssa",
+    cl::desc("Number loads and read-only calls by their MemorySSA clobbering access"),
+    cl::init(false));
+
+// Analyses MemorySSA needs for one function, built outside of any pass manager
+struct FunctionMemorySSA {
+    DominatorTree domTree;
+    TargetLibraryInfoImpl tliImpl;
+    TargetLibraryInfo tli;
+    AssumptionCache assumptions;
+    BasicAAResult basicAA;
+    AAResults aa;
+    MemorySSA memorySSA;
+
+    explicit FunctionMemorySSA(Function& func)
+        : domTree(func),
+          tliImpl(Triple(func.getParent()->getTargetTriple())),
+          tli(tliImpl),
+          assumptions(func),
+          basicAA(func.getParent()->getDataLayout(), func, tli, assumptions, &domTree),
+          aa(tli),
+          memorySSA((aa.addAAResult(basicAA), func), &aa, &domTree) {
+    }
+};
+
+// MemorySSA for func if --memory-ssa is given, built once per function
+static MemorySSA* memorySSAFor(Function& func) {
+    static std::map<const Function*, std::unique_ptr<FunctionMemorySSA>> analyses;
+    if (!UseMemorySSA || func.isDeclaration()) {
+        return nullptr;
+    }
+    auto& entry = analyses[&func];
+    if (!entry) {
+        entry = std::make_unique<FunctionMemorySSA>(func);
+    }
+    return &entry->memorySSA;
+}
+
+static cl::opt<std::string> CacheDirectory("vn-cache",
+    cl::desc("Reload congruence classes of unchanged functions from this directory, and store new ones"),
+    cl::value_desc("directory"),
+    cl::init(""));
+
+// Congruence class cache, if --vn-cache is given. Numbering through it is
+// function-local (see VNCache::numberFunction).
+std::unique_ptr<VNCache::Cache> globalCache;
+
+#if MW_VN_STATS
+// Per-iteration averages of the numbering statistics, as benchmark counters
+static void exportStats(benchmark::State& state, const VNStats::Stats& stats) {
+    stats.forEachCounter([&](const std::string& name, double value) {
+        state.counters[name] = name == "max_depth"
+            ? benchmark::Counter(value)
+            : benchmark::Counter(value, benchmark::Counter::kAvgIterations);
+    });
+}
+
+static cl::opt<std::string> TraceFile("vn-trace",
+    cl::desc("Write a Chrome trace-event timeline of numbering the module to this file"),
+    cl::value_desc("file"),
+    cl::init(""));
+
+static constexpr size_t MaxTraceEvents = 1 << 20;
+
+// Number every function once with tracing on
+static bool writeTrace(Module& module) {
+    std::error_code error;
+    raw_fd_ostream out(TraceFile, error);
+    if (error) {
+        std::cerr << "Could not open " << TraceFile << ": " << error.message() << "\n";
+        return false;
+    }
+    LLVMValueNumbering vn(cycleMode());
+    vn.stats().enableTrace(MaxTraceEvents);
+    for (auto& func : module) {
+        vn.setMemorySSA(memorySSAFor(func));
+        for (auto& bb : func) {
+            for (auto& inst : bb) {
+                vn.getValueNumber(&inst);
+            }
+        }
+    }
+    vn.stats().writeChromeTrace(out);
+    return true;
+}
+#endif
+
 // Global variables for module loading
 std::unique_ptr<LLVMContext> globalContext;
 std::unique_ptr<Module> globalModule;
@@ -78,29 +220,231 @@ static void BM_ValueNumbering(benchmark::State& state) {
         return;
     }
     
-    LLVMValueNumbering vn;
+    LLVMValueNumbering vn(cycleMode());
     
-    // Collect all instructions
-    std::vector<Value*> instructions;
+    // Collect all instructions, grouped by function so that each function is
+    // numbered against its own MemorySSA (built outside the timed loop)
+    std::vector<std::pair<MemorySSA*, std::vector<Value*>>> functions;
+    size_t instructionCount = 0;
     for (auto& func : *globalModule) {
+        auto& [memorySSA, instructions] = functions.emplace_back(memorySSAFor(func), std::vector<Value*>());
         for (auto& bb : func) {
             for (auto& inst : bb) {
                 instructions.push_back(&inst);
             }
         }
+        instructionCount += instructions.size();
     }
     
+    MW_VN_STAT(vn.stats().reset());
     for (auto _ : state) {
         vn.clear();
         
         // Compute value numbers for all instructions
-        for (auto* inst : instructions) {
-            auto valueNumber = vn.getValueNumber(inst);
-            benchmark::DoNotOptimize(valueNumber);
+        for (auto& [memorySSA, instructions] : functions) {
+            vn.setMemorySSA(memorySSA);
+            for (auto* inst : instructions) {
+                auto valueNumber = vn.getValueNumber(inst);
+                benchmark::DoNotOptimize(valueNumber);
+            }
         }
     }
     
-    state.SetItemsProcessed(state.iterations() * instructions.size());
+    state.SetItemsProcessed(state.iterations() * instructionCount);
+#if MW_VN_STATS
+    exportStats(state, vn.stats());
+#endif
+}
+
+// Hashing of one expression key with arg(1) words: folding each word through
+// llvm::hash_combine (arg(0) == 0), as computeInstructionVN used to, against
+// the flat multi-lane hash of VNExpressionKey (arg(0) == 1)
+static void BM_ExpressionHash(benchmark::State& state) {
+    bool flat = state.range(0) == 1;
+    VNExpressionKey::Words key;
+    for (int64_t i = 0; i < state.range(1); ++i) {
+        key.push_back(0x9e3779b97f4a7c15ULL * (i + 1));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(key.data());
+        uint64_t hash = 0;
+        if (flat) {
+            hash = VNExpressionKey::hash(key);
+        } else {
+            llvm::hash_code folded = llvm::hash_value(key[0]);
+            for (size_t i = 1; i < key.size(); ++i) {
+                folded = llvm::hash_combine(folded, key[i]);
+            }
+            hash = static_cast<uint64_t>(folded);
+        }
+        benchmark::DoNotOptimize(hash);
+    }
+}
+
+// Benchmark keeping the numbering up to date across small IR mutations. Each
+// iteration replaces one instruction with an identical copy (RAUW + erase) and
+// renumbers only what the mutation invalidated, instead of clear() and a full
+// renumbering as in BM_ValueNumbering.
+static void BM_IncrementalRenumbering(benchmark::State& state) {
+    if (!globalModule) {
+        state.SkipWithError("Module not loaded");
+        return;
+    }
+
+    // Mutate a copy, so later benchmarks still see the module as loaded
+    std::unique_ptr<Module> module = CloneModule(*globalModule);
+    LLVMValueNumbering vn(cycleMode());
+    vn.trackMutations(true);
+
+    // Pure instructions can be swapped for a copy without touching MemorySSA
+    std::vector<Instruction*> candidates;
+    for (auto& func : *module) {
+        for (auto& bb : func) {
+            for (auto& inst : bb) {
+                vn.getValueNumber(&inst);
+                if (!inst.getType()->isVoidTy() && !inst.isTerminator() && !isa<PHINode>(inst) &&
+                    !inst.mayReadOrWriteMemory()) {
+                    candidates.push_back(&inst);
+                }
+            }
+        }
+    }
+    if (candidates.empty()) {
+        state.SkipWithError("No pure instructions to mutate");
+        return;
+    }
+
+    size_t next = 0;
+    size_t renumbered = 0;
+    for (auto _ : state) {
+        Instruction*& inst = candidates[next++ % candidates.size()];
+        Instruction* copy = inst->clone();
+        copy->insertBefore(inst);
+        copy->takeName(inst);
+        inst->replaceAllUsesWith(copy);
+        inst->eraseFromParent();
+        inst = copy;
+        renumbered += vn.renumberInvalidated();
+    }
+
+    state.counters["renumbered/mutation"] =
+        benchmark::Counter(static_cast<double>(renumbered) / state.iterations());
+}
+
+// Benchmark an incremental build where every function is unchanged: each
+// function costs a structural hash and a cache read instead of numbering.
+static void BM_CachedValueNumbering(benchmark::State& state) {
+    if (!globalModule || !globalCache) {
+        state.SkipWithError("Module not loaded or --vn-cache not given");
+        return;
+    }
+
+    // Warm the cache outside the timed loop, and check that warm runs give
+    // the classes of numbering from scratch, as cold runs do
+    VNCache::StructuralHasher hasher;
+    LLVMValueNumbering vn(cycleMode());
+    LLVMValueNumbering fresh(cycleMode());
+    size_t instructionCount = 0;
+    for (auto& func : *globalModule) {
+        if (func.isDeclaration()) {
+            continue;
+        }
+        vn.setMemorySSA(memorySSAFor(func));
+        fresh.setMemorySSA(memorySSAFor(func));
+        VNCache::numberFunction(vn, func, hasher, *globalCache);
+        VNCache::numberFunction(vn, func, hasher, *globalCache);
+        if (VNCache::classesOf(vn, func) != VNCache::classesOf(fresh, func)) {
+            state.SkipWithError("Cached classes differ from numbering from scratch");
+            return;
+        }
+        instructionCount += VNCache::instructionCount(func);
+    }
+
+    size_t misses = 0;
+    for (auto _ : state) {
+        vn.clear();
+        for (auto& func : *globalModule) {
+            if (func.isDeclaration()) {
+                continue;
+            }
+            vn.setMemorySSA(memorySSAFor(func));
+            if (!VNCache::numberFunction(vn, func, hasher, *globalCache)) {
+                ++misses;
+            }
+        }
+    }
+
+    state.counters["misses"] = benchmark::Counter(static_cast<double>(misses));
+    state.SetItemsProcessed(state.iterations() * instructionCount);
+}
+
+enum class ReportFormat { JSON, Binary };
+
+static cl::opt<std::string> ReportFile("report",
+    cl::desc("Write a congruence report of the whole module to this file instead of the demonstration"),
+    cl::value_desc("file"),
+    cl::init(""));
+
+static cl::opt<ReportFormat> ReportFormatOpt("report-format",
+    cl::desc("Format of --report"),
+    cl::values(clEnumValN(ReportFormat::JSON, "json", "Streaming JSON"),
+               clEnumValN(ReportFormat::Binary, "binary", "Compact little-endian binary")),
+    cl::init(ReportFormat::JSON));
+
+// One report per defined function, numbered in parallel. MemorySSA is built
+// serially up front; afterwards each task only touches its own function's.
+static std::vector<VNReport::FunctionReport> buildReports(Module& module) {
+    std::vector<Function*> functions;
+    std::vector<MemorySSA*> analyses;
+    for (auto& func : module) {
+        if (!func.isDeclaration()) {
+            functions.push_back(&func);
+            analyses.push_back(memorySSAFor(func));
+        }
+    }
+
+    std::vector<VNReport::FunctionReport> reports(functions.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, functions.size()), [&](const tbb::blocked_range<size_t>& range) {
+        LLVMValueNumbering vn(cycleMode());
+        VNCache::StructuralHasher hasher;
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            vn.clear();
+            vn.setMemorySSA(analyses[i]);
+            if (globalCache) {
+                VNCache::numberFunction(vn, *functions[i], hasher, *globalCache);
+            }
+            reports[i] = VNReport::summarize(*functions[i], vn);
+        }
+    });
+    return reports;
+}
+
+static void writeReport(raw_ostream& out, Module& module, const std::vector<VNReport::FunctionReport>& reports) {
+    if (ReportFormatOpt == ReportFormat::JSON) {
+        VNReport::writeJSON(out, module.getName(), reports);
+    } else {
+        VNReport::writeBinary(out, reports);
+    }
+}
+
+// Benchmark generating and serializing the report, without the disk
+static void BM_Report(benchmark::State& state) {
+    if (!globalModule) {
+        state.SkipWithError("Module not loaded");
+        return;
+    }
+    std::string buffer;
+    size_t instructionCount = 0;
+    for (auto _ : state) {
+        buffer.clear();
+        raw_string_ostream out(buffer);
+        auto reports = buildReports(*globalModule);
+        writeReport(out, *globalModule, reports);
+        out.flush();
+        instructionCount = VNReport::summaryOf(reports).instructions;
+    }
+    state.counters["bytes"] = benchmark::Counter(static_cast<double>(buffer.size()));
+    state.SetItemsProcessed(state.iterations() * instructionCount);
 }
 
 static cl::opt<std::string> InputFile(cl::Positional, 
@@ -118,12 +462,92 @@ std::unique_ptr<Module> loadModuleFromFile(LLVMContext &context) {
     return module;
 }
 
+static cl::opt<bool> Stream("stream",
+    cl::desc("Load the input lazily and number one function at a time, printing its classes, then exit"),
+    cl::init(false));
+
+static cl::opt<bool> NoMemoryMap("no-mmap",
+    cl::desc("With --stream, read the input into memory instead of mapping it"),
+    cl::init(false));
+
+// Peak resident set size of this process in KiB
+static long peakRSSKiB() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+// Number the input function by function without ever holding more than one
+// body. Each line is a function followed by the class id of each of its
+// instructions in layout order, as stored by --vn-cache.
+int streamValueNumbering() {
+    LLVMContext context;
+    LLVMValueNumbering vn(cycleMode());
+    VNCache::StructuralHasher hasher; // Lives no longer than context
+    raw_ostream& out = outs();
+
+    auto visit = [&](Function& func) {
+        vn.clear();
+        // Built and destroyed per function, unlike memorySSAFor, so that no
+        // analysis outlives the body it was computed for
+        std::optional<FunctionMemorySSA> analyses;
+        if (UseMemorySSA) {
+            analyses.emplace(func);
+        }
+        vn.setMemorySSA(analyses ? &analyses->memorySSA : nullptr);
+
+        if (globalCache) {
+            VNCache::numberFunction(vn, func, hasher, *globalCache);
+        }
+        auto classes = VNCache::classesOf(vn, func);
+
+        out << "@" << func.getName() << ":";
+        for (auto id : classes) {
+            out << " " << id;
+        }
+        out << "\n";
+        vn.setMemorySSA(nullptr);
+    };
+
+    VNStreaming::Summary summary;
+    SMDiagnostic err;
+    if (!VNStreaming::forEachFunction(InputFile, context, !NoMemoryMap, visit, summary, err)) {
+        err.print("tLLVMValueNumbering", errs());
+        return 1;
+    }
+    out.flush();
+
+    std::cout << "\n=== Streaming Summary ===\n";
+    std::cout << "Functions: " << summary.functions << "\n";
+    std::cout << "Instructions: " << summary.instructions << "\n";
+    std::cout << "Largest function: " << summary.largestFunction << " instructions\n";
+    std::cout << "Peak RSS: " << peakRSSKiB() << " KiB\n";
+    return 0;
+}
+
+// IR text of value, so that it goes through std::cout in order with the rest
+// of the demonstration instead of through the separately buffered outs()
+static std::string printed(const Value& value) {
+    std::string text;
+    raw_string_ostream out(text);
+    value.print(out);
+    return out.str();
+}
+
 // Test function to demonstrate value numbering
 void demonstrateValueNumbering(Module *module) {
-    LLVMValueNumbering vn;
+    LLVMValueNumbering vn(cycleMode());
+    VNCache::StructuralHasher hasher;
     
-    std::cout << "=== LLVM Value Numbering Demonstration ===" << std::endl;
-    std::cout << "Module: " << module->getName().str() << std::endl;
+    std::cout << "=== LLVM Value Numbering Demonstration ===\n";
+    std::cout << "Module: " << module->getName().str() << "\n";
+    if (globalCache) {
+        std::cout << "Function-local classes (--vn-cache): instructions of different functions are never congruent\n";
+    }
     
     // Statistics tracking
     std::map<LLVMValueNumbering::ValueNumber, std::vector<llvm::Value*>> vnGroups;
@@ -134,12 +558,19 @@ void demonstrateValueNumbering(Module *module) {
     for (auto& func : *module) {
         if (func.isDeclaration()) continue; // Skip function declarations
         totalFunctions++;
+        vn.setMemorySSA(memorySSAFor(func));
+
+        bool cached = globalCache && VNCache::numberFunction(vn, func, hasher, *globalCache);
+        if (globalCache) {
+            std::cout << "\n(congruence classes " << (cached ? "reloaded from" : "stored in")
+                      << " " << CacheDirectory << ")";
+        }
         
-        std::cout << "\n--- Function: " << func.getName().str() << " ---" << std::endl;
+        std::cout << "\n--- Function: " << func.getName().str() << " ---\n";
         
         // Process all instructions and collect value numbers
         for (auto& bb : func) {
-            std::cout << "  Basic Block: " << bb.getName().str() << std::endl;
+            std::cout << "  Basic Block: " << bb.getName().str() << "\n";
             for (auto& inst : bb) {
                 auto vn_value = vn.getValueNumber(&inst);
                 totalInstructions++;
@@ -148,15 +579,15 @@ void demonstrateValueNumbering(Module *module) {
                 vnGroups[vn_value].push_back(&inst);
                 
                 std::cout << "    Instruction: ";
-                inst.print(outs());
-                std::cout << " => Value Number: " << vn_value << std::endl;
+                std::cout << printed(inst);
+                std::cout << " => Value Number: " << vn_value << "\n";
             }
         }
         
         // Only analyze the first function for detailed output
         if (totalFunctions == 1) {
             // Find congruent expressions in this function
-            std::cout << "\n    === Congruence Analysis for " << func.getName().str() << " ===" << std::endl;
+            std::cout << "\n    === Congruence Analysis for " << func.getName().str() << " ===\n";
             
             Value* firstAdd = nullptr;
             for (auto& bb : func) {
@@ -167,13 +598,13 @@ void demonstrateValueNumbering(Module *module) {
                             auto congruent = LLVMValueNumberingUtils::findCongruentExpressions(vn, firstAdd);
                             
                             std::cout << "    Expressions congruent to: ";
-                            firstAdd->print(outs());
-                            std::cout << std::endl;
+                            std::cout << printed(*firstAdd);
+                            std::cout << "\n";
                             
                             for (auto* expr : congruent) {
                                 std::cout << "      - ";
-                                expr->print(outs());
-                                std::cout << std::endl;
+                                std::cout << printed(*expr);
+                                std::cout << "\n";
                             }
                             break;
                         }
@@ -184,10 +615,10 @@ void demonstrateValueNumbering(Module *module) {
     }
     
     // Generate GVN Statistics
-    std::cout << "\n=== GVN Analysis Summary ===" << std::endl;
-    std::cout << "Total Functions: " << totalFunctions << std::endl;
-    std::cout << "Total Instructions: " << totalInstructions << std::endl;
-    std::cout << "Unique Value Numbers: " << vnGroups.size() << std::endl;
+    std::cout << "\n=== GVN Analysis Summary" << (globalCache ? " (function-local)" : "") << " ===\n";
+    std::cout << "Total Functions: " << totalFunctions << "\n";
+    std::cout << "Total Instructions: " << totalInstructions << "\n";
+    std::cout << "Unique Value Numbers: " << vnGroups.size() << "\n";
     
     // Count GVN candidates (value numbers with multiple instructions)
     int gvnCandidates = 0;
@@ -200,25 +631,25 @@ void demonstrateValueNumbering(Module *module) {
         }
     }
     
-    std::cout << "GVN Candidate Groups: " << gvnCandidates << std::endl;
-    std::cout << "Total Redundant Instructions: " << totalRedundantInstructions << std::endl;
+    std::cout << "GVN Candidate Groups: " << gvnCandidates << "\n";
+    std::cout << "Total Redundant Instructions: " << totalRedundantInstructions << "\n";
     
     if (gvnCandidates > 0) {
-        std::cout << "\n=== GVN Candidate Details ===" << std::endl;
+        std::cout << "\n=== GVN Candidate Details ===\n";
         int groupNum = 1;
         for (const auto& pair : vnGroups) {
             if (pair.second.size() > 1) {
-                std::cout << "Group " << groupNum++ << " (VN: " << pair.first << ", Count: " << pair.second.size() << "):" << std::endl;
+                std::cout << "Group " << groupNum++ << " (VN: " << pair.first << ", Count: " << pair.second.size() << "):\n";
                 for (auto* inst : pair.second) {
                     std::cout << "  ";
-                    inst->print(outs());
-                    std::cout << std::endl;
+                    std::cout << printed(*inst);
+                    std::cout << "\n";
                 }
-                std::cout << std::endl;
+                std::cout << "\n";
             }
         }
     } else {
-        std::cout << "No GVN candidates found - all instructions have unique value numbers." << std::endl;
+        std::cout << "No GVN candidates found - all instructions have unique value numbers.\n";
     }
 }
 
@@ -226,10 +657,41 @@ BENCHMARK(BM_ValueNumbering)
     ->Unit(benchmark::kMicrosecond)
     ->Iterations(10000);
 
+BENCHMARK(BM_CachedValueNumbering)
+    ->Unit(benchmark::kMicrosecond)
+    ->Iterations(10000);
+
+BENCHMARK(BM_IncrementalRenumbering)
+    ->Unit(benchmark::kMicrosecond)
+    ->Iterations(10000);
+
+BENCHMARK(BM_ExpressionHash)
+    ->ArgNames({"flat", "words"})
+    ->ArgsProduct({{0, 1}, {3, 5, 9}});
+
+BENCHMARK(BM_Report)
+    ->Unit(benchmark::kMicrosecond)
+    ->Iterations(1000);
+
 int main(int argc, char** argv) {
-    // Parse command line arguments first
+    // Benchmark flags are consumed first so that cl:: does not reject them,
+    // e.g. --benchmark_filter='^$' to only write a --report
+    benchmark::Initialize(&argc, argv);
     cl::ParseCommandLineOptions(argc, argv, "LLVM Value Numbering Analysis\n");
     
+    if (!CacheDirectory.empty()) {
+        globalCache = std::make_unique<VNCache::Cache>(CacheDirectory.getValue());
+    }
+
+    // Streaming never loads the whole module
+    if (Stream) {
+        if (InputFile == "-") {
+            std::cerr << "--stream needs an input file\n";
+            return 1;
+        }
+        return streamValueNumbering();
+    }
+
     // Initialize global context and load module
     globalContext = std::make_unique<LLVMContext>();
     
@@ -244,11 +706,32 @@ int main(int argc, char** argv) {
         }
     }
     
-    // Run demonstration first
-    demonstrateValueNumbering(globalModule.get());
+#if MW_VN_STATS
+    if (!TraceFile.empty() && !writeTrace(*globalModule)) {
+        return 1;
+    }
+#endif
+
+    if (!ReportFile.empty()) {
+        std::error_code error;
+        raw_fd_ostream out(ReportFile, error);
+        if (error) {
+            std::cerr << "Could not open " << ReportFile << ": " << error.message() << "\n";
+            return 1;
+        }
+        // Few large writes instead of one per line
+        out.SetBufferSize(1 << 20);
+        auto reports = buildReports(*globalModule);
+        writeReport(out, *globalModule, reports);
+        auto summary = VNReport::summaryOf(reports);
+        std::cout << "Report written to " << ReportFile << " (" << summary.functions << " functions, "
+                  << summary.instructions << " instructions, " << summary.redundant << " redundant)\n";
+    } else {
+        // Run demonstration first
+        demonstrateValueNumbering(globalModule.get());
+    }
     
     // Then run benchmarks
-    benchmark::Initialize(&argc, argv);
     benchmark::RunSpecifiedBenchmarks();
     benchmark::Shutdown();
     
@@ -1,3 +1,5 @@
+#include "SyntheticIR.hpp"
+
 #include <benchmark/benchmark.h>
 #include <llvm/Analysis/LoopAnalysisManager.h>
 #include <llvm/IR/LLVMContext.h>
@@ -10,7 +12,9 @@
 using namespace llvm;
 
 static cl::opt<std::string>
-    inputFileName(cl::Positional, cl::desc("<input bitcode>"), cl::init("-"));
+    inputFileName(cl::Positional,
+                  cl::desc("<input bitcode> - if not specified, uses a generated module"),
+                  cl::init(""));
 
 // Declare context and module in the right construction order.
 std::unique_ptr<LLVMContext> ctx;
@@ -64,17 +68,25 @@ BENCHMARK_CAPTURE(llvmPassPipeline, OptLevelO3, OptimizationLevel::O3)
 
 int main(int argc, char** argv) {
   // Create context and parse the input bitcode file.
+  // Benchmark flags are consumed first so that cl:: does not reject them
+  benchmark::Initialize(&argc, argv);
   cl::ParseCommandLineOptions(argc, argv, "LLVM System Compiler\n");
   ctx = std::make_unique<LLVMContext>();
   SMDiagnostic diag;
 
-  module = parseIRFile(inputFileName, diag, *ctx);
+  if (inputFileName.empty()) {
+    SyntheticIR::Options options;
+    options.functions = 16;
+    options.blocks = 32;
+    module = SyntheticIR::generate(*ctx, options);
+  } else {
+    module = parseIRFile(inputFileName, diag, *ctx);
+  }
   if (!module) {
     diag.print(argv[0], errs());
     return 1;
   }
 
-  benchmark::Initialize(&argc, argv);
   benchmark::RunSpecifiedBenchmarks();
   benchmark::Shutdown();
 
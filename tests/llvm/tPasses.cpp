@@ -1,3 +1,6 @@
+#include "SyntheticIR.hpp"
+#include "VNRedundancyElimination.hpp"
+
 #include <benchmark/benchmark.h>
 #include <llvm/Bitcode/BitcodeReader.h>
 #include <llvm/Bitcode/BitcodeWriter.h>
@@ -18,10 +21,12 @@
 
 using namespace llvm;
 
-enum Pass { DCE, LICM, SROA, GVN, INST_COMBINE, MEM2REG };
+enum Pass { DCE, LICM, SROA, GVN, VN_ELIMINATION, INST_COMBINE, MEM2REG };
 
 static cl::opt<std::string>
-    inputFileName(cl::Positional, cl::desc("<input bitcode>"), cl::init("-"));
+    inputFileName(cl::Positional,
+                  cl::desc("<input bitcode> - if not specified, uses a generated module"),
+                  cl::init(""));
 std::unique_ptr<LLVMContext> ctx;
 std::unique_ptr<Module> module;
 
@@ -40,6 +45,9 @@ static void llvmOptBenchmark(benchmark::State& aState, const ::Pass& aPass) {
     case ::Pass::GVN:
       passManager.add(createGVNPass());
       break;
+    case ::Pass::VN_ELIMINATION:
+      passManager.add(createVNRedundancyEliminationPass());
+      break;
     case ::Pass::INST_COMBINE:
       passManager.add(createInstructionCombiningPass());
       break;
@@ -48,8 +56,14 @@ static void llvmOptBenchmark(benchmark::State& aState, const ::Pass& aPass) {
       break;
   }
 
+  // Every iteration runs on a fresh copy of the input so that each pass is
+  // timed on the same IR rather than on the output of the previous run.
+  std::unique_ptr<Module> input;
   for (auto _ : aState) {
-    passManager.run(*module);
+    aState.PauseTiming();
+    input = CloneModule(*module);
+    aState.ResumeTiming();
+    passManager.run(*input);
   }
 }
 
@@ -62,6 +76,10 @@ BENCHMARK_CAPTURE(llvmOptBenchmark, SROA, ::Pass::SROA)
     ->Unit(benchmark::kMillisecond);
 BENCHMARK_CAPTURE(llvmOptBenchmark, GVN, ::Pass::GVN)
     ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(llvmOptBenchmark,
+                  VNRedundancyElimination,
+                  ::Pass::VN_ELIMINATION)
+    ->Unit(benchmark::kMillisecond);
 BENCHMARK_CAPTURE(llvmOptBenchmark, InstCombine, ::Pass::INST_COMBINE)
     ->Unit(benchmark::kMillisecond);
 BENCHMARK_CAPTURE(llvmOptBenchmark, Mem2Reg, ::Pass::MEM2REG)
@@ -75,19 +93,27 @@ int main(int argc, char** argv) {
   initializeAnalysis(passRegistry);
   initializeTransformUtils(passRegistry);
 
+  // Benchmark flags are consumed first so that cl:: does not reject them
+  benchmark::Initialize(&argc, argv);
   cl::ParseCommandLineOptions(argc, argv, "LLVM System Compiler\n");
 
   // Create context and parse the input bitcode file
   ctx = std::make_unique<LLVMContext>();
   SMDiagnostic diag;
 
-  module = parseIRFile(inputFileName, diag, *ctx);
+  if (inputFileName.empty()) {
+    SyntheticIR::Options options;
+    options.functions = 16;
+    options.blocks = 32;
+    module = SyntheticIR::generate(*ctx, options);
+  } else {
+    module = parseIRFile(inputFileName, diag, *ctx);
+  }
   if (!module) {
     diag.print(argv[0], errs());
     return 1;
   }
 
-  benchmark::Initialize(&argc, argv);
   benchmark::RunSpecifiedBenchmarks();
   benchmark::Shutdown();
 
@@ -0,0 +1,80 @@
+#include "SyntheticIR.hpp"
+
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <iostream>
+#include <system_error>
+
+using namespace llvm;
+
+static cl::opt<std::string> OutputFile("o",
+                                       cl::desc("Output file (.ll, or bitcode with --emit-bitcode)"),
+                                       cl::value_desc("file"),
+                                       cl::init("-"));
+
+static cl::opt<bool> EmitBitcode("emit-bitcode", cl::desc("Write bitcode instead of text IR"), cl::init(false));
+
+static cl::opt<unsigned> Functions("functions", cl::desc("Functions in the module"), cl::init(1));
+static cl::opt<unsigned> Blocks("blocks", cl::desc("Blocks per function"), cl::init(8));
+static cl::opt<unsigned> InstructionsPerBlock("instructions-per-block",
+                                              cl::desc("Instructions per block, excluding PHIs and terminators"),
+                                              cl::init(64));
+static cl::opt<double> Redundancy("redundancy", cl::desc("Share of repeated expressions (0-1)"), cl::init(0.25));
+static cl::opt<double> CommutativeSwap("commutative-swap",
+                                       cl::desc("Share of repeats with commutative operands swapped (0-1)"),
+                                       cl::init(0.5));
+static cl::opt<double> LoopDensity("loop-density", cl::desc("Share of blocks that are loops (0-1)"), cl::init(0.1));
+static cl::opt<unsigned> PhisPerLoop("phis-per-loop",
+                                     cl::desc("Loop-carried values besides the counter"),
+                                     cl::init(2));
+static cl::opt<double> MemoryRatio("memory-ratio", cl::desc("Share of loads and stores (0-1)"), cl::init(0.1));
+static cl::opt<double> StoreRatio("store-ratio",
+                                  cl::desc("Share of stores among memory instructions (0-1)"),
+                                  cl::init(0.3));
+static cl::opt<unsigned> MemorySlots("memory-slots", cl::desc("Distinct addresses loaded and stored"), cl::init(16));
+static cl::opt<uint64_t> Seed("seed", cl::desc("Random seed"), cl::init(1));
+
+int main(int argc, char** argv) {
+  cl::ParseCommandLineOptions(argc, argv, "Synthetic IR generator for value numbering benchmarks\n");
+
+  SyntheticIR::Options options;
+  options.functions = Functions;
+  options.blocks = Blocks;
+  options.instructionsPerBlock = InstructionsPerBlock;
+  options.redundancy = Redundancy;
+  options.commutativeSwap = CommutativeSwap;
+  options.loopDensity = LoopDensity;
+  options.phisPerLoop = PhisPerLoop;
+  options.memoryRatio = MemoryRatio;
+  options.storeRatio = StoreRatio;
+  options.memorySlots = MemorySlots;
+  options.seed = Seed;
+  if (options.blocks == 0) {
+    std::cerr << "--blocks must be positive\n";
+    return 1;
+  }
+
+  LLVMContext context;
+  auto module = SyntheticIR::generate(context, options);
+  if (verifyModule(*module, &errs())) {
+    return 1;
+  }
+
+  std::error_code error;
+  raw_fd_ostream out(OutputFile, error, EmitBitcode ? sys::fs::OF_None : sys::fs::OF_Text);
+  if (error) {
+    std::cerr << "Could not open " << OutputFile << ": " << error.message() << "\n";
+    return 1;
+  }
+  if (EmitBitcode) {
+    WriteBitcodeToFile(*module, out);
+  } else {
+    module->print(out, nullptr);
+  }
+  return 0;
+}
@@ -1,23 +1,41 @@
+#include "LLVMValueNumbering.hpp"
+#include "SyntheticIR.hpp"
 #include "VNTable.hpp"
 
 #include <benchmark/benchmark.h>
 #include <boost/range.hpp>
+#include <llvm/ADT/DenseSet.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Support/SourceMgr.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
 #include <memory>
 #include <numeric>
+#include <set>
+#include <string>
 #include <tbb/parallel_for_each.h>
+#include <tbb/task_arena.h>
+#include <thread>
 #include <vector>
 
 using LlvmVNTable = VNTable<llvm::Value*>;
 
 using namespace llvm;
 
-// Global variable to store IR file path from command line
-static std::string g_irFilePath = "./benchmarks/synthetic_heavy_gvn.ll";
+// Number of congruence queries per iteration, as in tests/tVNTableCongruence.cpp
+constexpr size_t OP_COUNT = 1000000;
+
+// IR file path from the command line; without one the module is generated
+static std::string g_irFilePath;
+
+// Wall-clock seconds per iteration of each strategy on one thread, the
+// baseline of the speedup and efficiency counters. Thread counts run in
+// increasing order, so the one-thread run of a family is recorded first.
+static std::map<std::string, double> g_serialSeconds;
 
 class SyntheticIRFixture : public ::benchmark::Fixture {
 protected:
@@ -27,53 +45,62 @@ protected:
   std::vector<llvm::Value*> values_;
 
   void SetUp(const ::benchmark::State& state) override {
-    // Load the synthetic IR file
-    llvm::SMDiagnostic error;
-    module_ = llvm::parseIRFile(g_irFilePath, error, context_);
+    // Load the synthetic IR file, or generate it in memory
+    if (g_irFilePath.empty()) {
+      SyntheticIR::Options options;
+      options.functions = 64;
+      options.blocks = 32;
+      options.redundancy = 0.4;
+      module_ = SyntheticIR::generate(context_, options);
+    } else {
+      llvm::SMDiagnostic error;
+      module_ = llvm::parseIRFile(g_irFilePath, error, context_);
+    }
 
     if (!module_) {
       ::benchmark::State& mutableState = const_cast<::benchmark::State&>(state);
-      mutableState.SkipWithError("Failed to load synthetic_heavy_gvn.ll");
+      mutableState.SkipWithError(("Failed to load " + g_irFilePath).c_str());
       return;
     }
 
-    // Create VNTable and populate with values from the module
-    testTable_ = std::make_unique<LlvmVNTable>();
-
-    // Collect all values from the module
+    // Collect arguments, instructions and the constants they use
+    llvm::DenseSet<llvm::Value*> constants;
     for (auto& func : *module_) {
-      // Add function arguments
       for (auto& arg : func.args()) {
         values_.push_back(&arg);
-        testTable_->value(&arg); // Ensure value is in table
       }
-
-      // Add all instructions
       for (auto& bb : func) {
         for (auto& inst : bb) {
           values_.push_back(&inst);
-          testTable_->value(&inst); // Ensure value is in table
+          for (auto& operand : inst.operands()) {
+            auto* constant = llvm::dyn_cast<llvm::Constant>(operand.get());
+            if (constant && constants.insert(constant).second) {
+              values_.push_back(constant);
+            }
+          }
         }
       }
     }
 
-    // Also add constants that appear in the module
+    // Populate the table with real value numbers, so that congruence classes
+    // have the sizes and skew of the IR instead of a uniform modulus. Numbers
+    // are per function, as the passes use them.
+    testTable_ = std::make_unique<LlvmVNTable>();
+    LLVMValueNumbering vn;
     for (auto& func : *module_) {
+      vn.clear();
+      for (auto& arg : func.args()) {
+        testTable_->insertOrReplace(&arg, vn.getValueNumber(&arg));
+      }
       for (auto& bb : func) {
         for (auto& inst : bb) {
-          for (auto& operand : inst.operands()) {
-            if (auto* constant =
-                    llvm::dyn_cast<llvm::Constant>(operand.get())) {
-              if (std::find(values_.begin(), values_.end(), constant) ==
-                  values_.end()) {
-                values_.push_back(constant);
-                testTable_->value(constant); // Ensure value is in table
-              }
-            }
-          }
+          testTable_->insertOrReplace(&inst, vn.getValueNumber(&inst));
         }
       }
     }
+    for (auto* constant : constants) {
+      testTable_->insertOrReplace(constant, vn.getValueNumber(constant));
+    }
   }
 
   void TearDown(const ::benchmark::State& state) override {
@@ -91,7 +118,61 @@ public:
   }
 };
 
-// Benchmark congruence_naive implementation on synthetic IR
+// Visits one congruence class
+static void consume(const LlvmVNTable::Congruence& aCongruence) {
+  for (const auto& [entity, entityVN] : boost::make_iterator_range(aCongruence)) {
+    auto l = entity;
+    auto r = entityVN;
+    ::benchmark::DoNotOptimize(l);
+    ::benchmark::DoNotOptimize(r);
+  }
+}
+
+// The distinct value numbers of the OP_COUNT queried values
+static std::set<LlvmVNTable::ValueNumber> queriedKeys(const LlvmVNTable& aTable,
+                                                      const std::vector<llvm::Value*>& aValues) {
+  std::set<LlvmVNTable::ValueNumber> keys;
+  for (size_t i = 0; i != OP_COUNT; ++i) {
+    if (auto optVN = aTable.value(aValues[i % aValues.size()])) {
+      keys.insert(*optVN);
+    }
+  }
+  return keys;
+}
+
+// Runs aBody once per iteration inside an arena of aThreads threads and
+// reports the speedup over one thread and over congruence_naive, and the
+// parallel efficiency (speedup per thread)
+template <typename Body>
+static void runStrategy(benchmark::State& aState, const std::string& aStrategy, int aThreads, Body&& aBody) {
+  tbb::task_arena arena(aThreads);
+
+  double seconds = 0;
+  for (auto _ : aState) {
+    auto start = std::chrono::steady_clock::now();
+    arena.execute(aBody);
+    seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  aState.SetItemsProcessed(aState.iterations() * OP_COUNT);
+  if (aState.iterations() == 0) {
+    return;
+  }
+
+  double perIteration = seconds / aState.iterations();
+  if (aThreads == 1) {
+    g_serialSeconds[aStrategy] = perIteration;
+  }
+  if (auto it = g_serialSeconds.find(aStrategy); it != g_serialSeconds.end()) {
+    double speedup = it->second / perIteration;
+    aState.counters["speedup"] = speedup;
+    aState.counters["efficiency"] = speedup / aThreads;
+  }
+  if (auto it = g_serialSeconds.find("congruence_naive"); it != g_serialSeconds.end()) {
+    aState.counters["vs_naive"] = it->second / perIteration;
+  }
+}
+
+// Naive approach - Sequential lookup, Sequential processing
 BENCHMARK_DEFINE_F(SyntheticIRFixture,
                    congruence_naive)(benchmark::State& aState) {
   auto testTable = getTestTable();
@@ -102,29 +183,18 @@ BENCHMARK_DEFINE_F(SyntheticIRFixture,
     return;
   }
 
-  for (auto _ : aState) {
-    // Test congruence operations on random value numbers from the synthetic IR
-    for (size_t i = 0; i < 1000000; ++i) {
+  runStrategy(aState, "congruence_naive", 1, [&] {
+    for (size_t i = 0; i != OP_COUNT; ++i) {
       auto optVN = testTable->value(values[i % values.size()]);
       if (!optVN)
         continue;
-      auto vn = *optVN;
-      auto result = testTable->congruence(vn);
-
-      for (const auto& [entity, entityVN] :
-           boost::make_iterator_range(result)) {
-        auto l = entity;
-        auto r = entityVN;
-        ::benchmark::DoNotOptimize(l);
-        ::benchmark::DoNotOptimize(r);
-      }
+      consume(testTable->congruence(*optVN));
     }
-  }
-
-  aState.SetItemsProcessed(aState.iterations() * 1000000);
+  });
 }
 
-// Benchmark congruence_uniquify_naive implementation on synthetic IR
+// Same as above except that the value numbers to look up are collected and
+// uniquified first
 BENCHMARK_DEFINE_F(SyntheticIRFixture,
                    congruence_uniquify_naive)(benchmark::State& aState) {
   auto testTable = getTestTable();
@@ -135,28 +205,14 @@ BENCHMARK_DEFINE_F(SyntheticIRFixture,
     return;
   }
 
-  for (auto _ : aState) {
-    for (size_t i = 0; i < 1000000; ++i) {
-      auto optVN = testTable->value(values[i % values.size()]);
-      if (!optVN)
-        continue;
-      auto vn = *optVN;
-      auto result = testTable->congruence(vn);
-
-      for (const auto& [entity, entityVN] :
-           boost::make_iterator_range(result)) {
-        auto l = entity;
-        auto r = entityVN;
-        ::benchmark::DoNotOptimize(l);
-        ::benchmark::DoNotOptimize(r);
-      }
+  runStrategy(aState, "congruence_uniquify_naive", 1, [&] {
+    for (auto key : queriedKeys(*testTable, values)) {
+      consume(testTable->congruence(key));
     }
-  }
-
-  aState.SetItemsProcessed(aState.iterations() * 1000000);
+  });
 }
 
-// Benchmark congruence_parallel_results_only implementation on synthetic IR
+// Sequential lookup, Parallel processing of each class's members
 BENCHMARK_DEFINE_F(SyntheticIRFixture,
                    congruence_parallel_results_only)(benchmark::State& aState) {
   auto testTable = getTestTable();
@@ -167,28 +223,30 @@ BENCHMARK_DEFINE_F(SyntheticIRFixture,
     return;
   }
 
-  for (auto _ : aState) {
-    for (size_t i = 0; i < 1000000; ++i) {
+  runStrategy(aState, "congruence_parallel_results_only", static_cast<int>(aState.range(0)), [&] {
+    std::vector<llvm::Value*> members;
+    for (size_t i = 0; i != OP_COUNT; ++i) {
       auto optVN = testTable->value(values[i % values.size()]);
       if (!optVN)
         continue;
-      auto vn = *optVN;
-      auto result = testTable->congruence(vn);
-
-      for (const auto& [entity, entityVN] :
-           boost::make_iterator_range(result)) {
-        auto l = entity;
-        auto r = entityVN;
-        ::benchmark::DoNotOptimize(l);
-        ::benchmark::DoNotOptimize(r);
+      auto result = testTable->congruence(*optVN);
+
+      // Collect the results sequentially
+      members.clear();
+      for (const auto& [entity, entityVN] : boost::make_iterator_range(result)) {
+        members.push_back(entity);
       }
-    }
-  }
 
-  aState.SetItemsProcessed(aState.iterations() * 1000000);
+      // Now parallelize processing with Intel TBB
+      tbb::parallel_for_each(members.begin(), members.end(), [](llvm::Value* aValue) {
+        auto opcode = aValue->getValueID();
+        ::benchmark::DoNotOptimize(opcode);
+      });
+    }
+  });
 }
 
-// Benchmark congruence_fast implementation on synthetic IR
+// Parallel lookup/processing over unique keys (value numbers)
 BENCHMARK_DEFINE_F(SyntheticIRFixture,
                    congruence_fast)(benchmark::State& aState) {
   auto testTable = getTestTable();
@@ -199,28 +257,15 @@ BENCHMARK_DEFINE_F(SyntheticIRFixture,
     return;
   }
 
-  for (auto _ : aState) {
-    for (size_t i = 0; i < 1000000; ++i) {
-      auto optVN = testTable->value(values[i % values.size()]);
-      if (!optVN)
-        continue;
-      auto vn = *optVN;
-      auto result = testTable->congruence(vn);
-
-      for (const auto& [entity, entityVN] :
-           boost::make_iterator_range(result)) {
-        auto l = entity;
-        auto r = entityVN;
-        ::benchmark::DoNotOptimize(l);
-        ::benchmark::DoNotOptimize(r);
-      }
-    }
-  }
-
-  aState.SetItemsProcessed(aState.iterations() * 1000000);
+  runStrategy(aState, "congruence_fast", static_cast<int>(aState.range(0)), [&] {
+    auto keys = queriedKeys(*testTable, values);
+    tbb::parallel_for_each(keys.begin(), keys.end(), [&](LlvmVNTable::ValueNumber aKey) {
+      consume(testTable->congruence(aKey));
+    });
+  });
 }
 
-// Benchmark congruence_parallel_lookup implementation on synthetic IR
+// Parallelize the outermost benchmarking loop (operational loop)
 BENCHMARK_DEFINE_F(SyntheticIRFixture,
                    congruence_parallel_lookup)(benchmark::State& aState) {
   auto testTable = getTestTable();
@@ -231,30 +276,28 @@ BENCHMARK_DEFINE_F(SyntheticIRFixture,
     return;
   }
 
-  for (auto _ : aState) {
-    // Create indices for parallel processing
-    std::vector<size_t> indices(1000000);
-    std::iota(indices.begin(), indices.end(), 0);
+  // Create indices for parallel processing
+  std::vector<size_t> indices(OP_COUNT);
+  std::iota(indices.begin(), indices.end(), 0);
 
-    // Parallelize the congruence lookups using TBB
+  runStrategy(aState, "congruence_parallel_lookup", static_cast<int>(aState.range(0)), [&] {
     tbb::parallel_for_each(indices.begin(), indices.end(), [&](size_t i) {
       auto optVN = testTable->value(values[i % values.size()]);
       if (!optVN)
         return;
-      auto vn = *optVN;
-      auto result = testTable->congruence(vn);
-
-      for (const auto& [entity, entityVN] :
-           boost::make_iterator_range(result)) {
-        auto l = entity;
-        auto r = entityVN;
-        ::benchmark::DoNotOptimize(l);
-        ::benchmark::DoNotOptimize(r);
-      }
+      consume(testTable->congruence(*optVN));
     });
-  }
+  });
+}
 
-  aState.SetItemsProcessed(aState.iterations() * 1000000);
+// Thread counts 1, 2, 4, ... up to and including the hardware concurrency
+static void threadSweep(benchmark::internal::Benchmark* aBenchmark) {
+  int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  aBenchmark->ArgName("threads");
+  for (int threads = 1; threads < cores; threads *= 2) {
+    aBenchmark->Arg(threads);
+  }
+  aBenchmark->Arg(cores);
 }
 
 BENCHMARK_REGISTER_F(SyntheticIRFixture, congruence_naive)
@@ -264,12 +307,18 @@ BENCHMARK_REGISTER_F(SyntheticIRFixture, congruence_uniquify_naive)
     ->Unit(benchmark::kMillisecond);
 
 BENCHMARK_REGISTER_F(SyntheticIRFixture, congruence_parallel_results_only)
+    ->Apply(threadSweep)
+    ->UseRealTime()
     ->Unit(benchmark::kMillisecond);
 
 BENCHMARK_REGISTER_F(SyntheticIRFixture, congruence_fast)
+    ->Apply(threadSweep)
+    ->UseRealTime()
     ->Unit(benchmark::kMillisecond);
 
 BENCHMARK_REGISTER_F(SyntheticIRFixture, congruence_parallel_lookup)
+    ->Apply(threadSweep)
+    ->UseRealTime()
     ->Unit(benchmark::kMillisecond);
 
 int main(int argc, char** argv) {
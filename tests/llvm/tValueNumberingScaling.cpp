@@ -0,0 +1,161 @@
+#include "LLVMValueNumbering.hpp"
+#include "SyntheticIR.hpp"
+#include "VNRedundancyElimination.hpp"
+
+#include <benchmark/benchmark.h>
+#include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/LoopAnalysisManager.h>
+#include <llvm/Analysis/MemorySSA.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Transforms/Scalar/GVN.h>
+#include <llvm/Transforms/Scalar/NewGVN.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::opt<unsigned> Seed("seed",
+                              cl::desc("Seed of the generated modules"),
+                              cl::init(1));
+
+static cl::opt<unsigned> MaxInstructions("max-instructions",
+                                         cl::desc("Largest generated function, in instructions"),
+                                         cl::init(1 << 16));
+
+enum class Engine { NUMBERING, ELIMINATION, GVN, NEW_GVN };
+
+// One function of about aInstructions instructions in blocks of 64, with
+// aRedundancy percent of repeated expressions
+static std::unique_ptr<Module> generateModule(LLVMContext& aContext,
+                                              size_t aInstructions,
+                                              unsigned aRedundancy) {
+  SyntheticIR::Options options;
+  options.blocks = std::max<size_t>(aInstructions / 64, 1);
+  options.instructionsPerBlock = 64;
+  options.redundancy = aRedundancy / 100.0;
+  options.seed = Seed;
+  return SyntheticIR::generate(aContext, options, "scaling");
+}
+
+static long peakRSSKiB() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+// New pass manager analyses, registered once per iteration so that no
+// analysis result survives from one cloned module to the next
+struct Analyses {
+  LoopAnalysisManager loops;
+  FunctionAnalysisManager functions;
+  CGSCCAnalysisManager sccs;
+  ModuleAnalysisManager modules;
+
+  Analyses() {
+    PassBuilder builder;
+    builder.registerModuleAnalyses(modules);
+    builder.registerCGSCCAnalyses(sccs);
+    builder.registerFunctionAnalyses(functions);
+    builder.registerLoopAnalyses(loops);
+    builder.crossRegisterProxies(loops, functions, sccs, modules);
+  }
+};
+
+static void run(Engine aEngine, Module& aModule, Analyses& aAnalyses) {
+  for (auto& function : aModule) {
+    if (function.isDeclaration()) {
+      continue;
+    }
+    switch (aEngine) {
+      case Engine::NUMBERING: {
+        LLVMValueNumbering vn;
+        for (auto& bb : function) {
+          for (auto& inst : bb) {
+            benchmark::DoNotOptimize(vn.getValueNumber(&inst));
+          }
+        }
+        break;
+      }
+      case Engine::ELIMINATION: {
+        auto& domTree = aAnalyses.functions.getResult<DominatorTreeAnalysis>(function);
+        auto& memorySSA = aAnalyses.functions.getResult<MemorySSAAnalysis>(function).getMSSA();
+        VNRedundancyElimination::run(domTree, &memorySSA);
+        break;
+      }
+      case Engine::GVN:
+        GVNPass().run(function, aAnalyses.functions);
+        break;
+      case Engine::NEW_GVN:
+        NewGVNPass().run(function, aAnalyses.functions);
+        break;
+    }
+  }
+}
+
+// Times aEngine on a fresh module of state.range(0) instructions. The
+// transforms change their input, so every iteration gets its own clone.
+static void BM_Scaling(benchmark::State& aState, Engine aEngine, unsigned aRedundancy) {
+  LLVMContext context;
+  auto module = generateModule(context, aState.range(0), aRedundancy);
+
+  for (auto _ : aState) {
+    aState.PauseTiming();
+    auto input = CloneModule(*module);
+    auto analyses = std::make_unique<Analyses>();
+    aState.ResumeTiming();
+
+    run(aEngine, *input, *analyses);
+
+    aState.PauseTiming();
+    analyses.reset();
+    input.reset();
+    aState.ResumeTiming();
+  }
+
+  aState.SetComplexityN(aState.range(0));
+  aState.SetItemsProcessed(aState.iterations() * aState.range(0));
+  // Process-wide high-water mark; run one benchmark per process (with
+  // --benchmark_filter) to attribute it to a single engine and size
+  aState.counters["peak_rss_kib"] = benchmark::Counter(static_cast<double>(peakRSSKiB()));
+}
+
+int main(int argc, char** argv) {
+  // Benchmark flags are consumed first so that cl:: does not reject them
+  benchmark::Initialize(&argc, argv);
+  cl::ParseCommandLineOptions(argc, argv, "Scaling of value numbering against LLVM's GVN passes\n");
+
+  const std::pair<const char*, Engine> engines[] = {{"Numbering", Engine::NUMBERING},
+                                                    {"VNRedundancyElimination", Engine::ELIMINATION},
+                                                    {"GVNPass", Engine::GVN},
+                                                    {"NewGVNPass", Engine::NEW_GVN}};
+  // One family per engine and redundancy ratio, so that Complexity() fits
+  // each of them over the function size alone
+  for (auto& [name, engine] : engines) {
+    for (unsigned redundancy : {0u, 25u, 50u}) {
+      std::string family = std::string("BM_Scaling/") + name + "/redundancy:" + std::to_string(redundancy);
+      benchmark::RegisterBenchmark(family.c_str(), BM_Scaling, engine, redundancy)
+          ->RangeMultiplier(4)
+          ->Range(1 << 10, MaxInstructions)
+          ->Complexity()
+          ->Unit(benchmark::kMillisecond);
+    }
+  }
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+
+  return 0;
+}
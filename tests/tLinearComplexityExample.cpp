@@ -1,7 +1,13 @@
 #include "LinearSearch.hpp"
+#include "Search.hpp"
 
 #include <benchmark/benchmark.h>
+#include <algorithm>
+#include <limits>
 #include <random>
+#include <tbb/task_arena.h>
+#include <thread>
+#include <vector>
 
 using ContainerType = std::vector<int>;
 
@@ -48,4 +54,160 @@ BENCHMARK_REGISTER_F(ContainerFixture, bmLinearSearch)
     ->Range(1e3, 1e6)
     ->Unit(benchmark::kMicrosecond)
     ->Complexity();
+
+// Whether the aISA kernel finds what the scalar loop finds in arrays of
+// every length up to past four AVX-512 registers of bytes (so every tail
+// length): the first, middle and last element, a miss and, for floating
+// point, NaN (among the elements and as the needle) and -0.0
+template <typename T>
+static bool agreesWithScalar(LinearSearchKernels::ISA aISA) {
+  using namespace LinearSearchKernels;
+  auto search = kernel<T>(aISA);
+  std::vector<T> data;
+  std::vector<T> queries;
+  for (size_t size = 0; size <= 300; ++size) {
+    data.resize(size);
+    for (size_t i = 0; i != size; ++i) {
+      data[i] = static_cast<T>(i + 1);
+    }
+    queries = {static_cast<T>(size + 1), static_cast<T>(-1)};
+    if (size != 0) {
+      queries.insert(queries.end(), {data[0], data[size / 2], data[size - 1]});
+    }
+    if constexpr (std::is_floating_point_v<T>) {
+      if (size != 0) {
+        data[size / 3] = std::numeric_limits<T>::quiet_NaN();
+        data[size - 1] = 0;
+      }
+      queries.insert(queries.end(), {std::numeric_limits<T>::quiet_NaN(), static_cast<T>(-0.0)});
+    }
+    for (T query : queries) {
+      if (search(data.data(), size, query) != findScalar(data.data(), size, query)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// The same missing-value scan through each kernel, scalar included, to
+// compare them on this CPU. Kernels the CPU lacks are skipped, and so are
+// kernels that disagree with the scalar loop.
+static void bmLinearSearchKernel(benchmark::State& aState) {
+  using namespace LinearSearchKernels;
+  auto isa = static_cast<ISA>(aState.range(1));
+  if (!supported(isa)) {
+    aState.SkipWithError("Instruction set not supported by this CPU");
+    return;
+  }
+  if (!agreesWithScalar<int8_t>(isa) || !agreesWithScalar<int>(isa) || !agreesWithScalar<int64_t>(isa) ||
+      !agreesWithScalar<float>(isa) || !agreesWithScalar<double>(isa)) {
+    aState.SkipWithError("Kernel disagrees with the scalar loop");
+    return;
+  }
+  aState.SetLabel(name(isa));
+
+  ContainerType data(aState.range(0));
+  for (size_t i = 0; i != data.size(); ++i) {
+    data[i] = static_cast<int>(i);
+  }
+  auto search = kernel<int>(isa);
+  int valToSearch = static_cast<int>(data.size()) + 1;
+
+  for (auto _ : aState) {
+    auto result = search(data.data(), data.size(), valToSearch);
+    benchmark::DoNotOptimize(result);
+  }
+
+  aState.SetBytesProcessed(aState.iterations() * data.size() * sizeof(int));
+}
+
+BENCHMARK(bmLinearSearchKernel)
+    ->ArgNames({"size", "isa"})
+    ->ArgsProduct({{1000, 10000, 100000, 1000000},
+                   {static_cast<int>(LinearSearchKernels::ISA::SCALAR),
+                    static_cast<int>(LinearSearchKernels::ISA::SSE2),
+                    static_cast<int>(LinearSearchKernels::ISA::AVX2),
+                    static_cast<int>(LinearSearchKernels::ISA::AVX512)}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Random hits in a small sorted array, where the crossover from scanning to
+// binary search lies: the vectorized scan alone, and Search<int>, which
+// scans only below its calibrated crossover (see SearchThresholds.hpp)
+template <bool SCAN>
+static void bmSmallSortedSearch(benchmark::State& aState) {
+  ContainerType data(aState.range(0));
+  for (size_t i = 0; i != data.size(); ++i) {
+    data[i] = static_cast<int>(2 * i);
+  }
+  LinearSearchView scan(data);
+  Search<int> search(data);
+  aState.SetLabel(SCAN ? "scan" : strategyName(search.strategy()));
+
+  static std::default_random_engine engine;
+  auto dist = std::uniform_int_distribution<size_t>(0, data.size() - 1);
+  std::vector<int> queries(1 << 12);
+  for (auto& query : queries) {
+    query = data[dist(engine)];
+  }
+
+  size_t next = 0;
+  for (auto _ : aState) {
+    int value = queries[next++ & (queries.size() - 1)];
+    auto result = SCAN ? scan.rank(value) : search.rank(value);
+    benchmark::DoNotOptimize(result);
+  }
+  aState.SetItemsProcessed(aState.iterations());
+}
+
+BENCHMARK_TEMPLATE(bmSmallSortedSearch, true)
+    ->RangeMultiplier(2)
+    ->Range(8, 1024)
+    ->Unit(benchmark::kNanosecond);
+BENCHMARK_TEMPLATE(bmSmallSortedSearch, false)
+    ->RangeMultiplier(2)
+    ->Range(8, 1024)
+    ->Unit(benchmark::kNanosecond);
+
+// One match three quarters into a large array, found serially (threads 0)
+// and by rankParallel() in an arena of each thread count. Bytes processed
+// count only the elements before the match, what a serial scan reads.
+static void bmParallelLinearSearch(benchmark::State& aState) {
+  ContainerType data(aState.range(0));
+  for (size_t i = 0; i != data.size(); ++i) {
+    data[i] = static_cast<int>(i);
+  }
+  size_t position = data.size() / 4 * 3;
+  int valToSearch = data[position];
+  LinearSearchView view(data);
+  int threads = static_cast<int>(aState.range(1));
+  tbb::task_arena arena(std::max(1, threads));
+
+  for (auto _ : aState) {
+    auto result = threads == 0 ? view.rank(valToSearch) : view.rankParallel(valToSearch, arena);
+    benchmark::DoNotOptimize(result);
+  }
+
+  aState.SetBytesProcessed(aState.iterations() * position * sizeof(int));
+}
+
+// Serial, then thread counts 1, 2, 4, ... up to and including the hardware
+// concurrency
+static void threadSweep(benchmark::internal::Benchmark* aBenchmark) {
+  int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  aBenchmark->ArgNames({"size", "threads"});
+  for (int64_t size : {1000000, 10000000, 100000000}) {
+    aBenchmark->Args({size, 0});
+    for (int threads = 1; threads < cores; threads *= 2) {
+      aBenchmark->Args({size, threads});
+    }
+    aBenchmark->Args({size, cores});
+  }
+}
+
+BENCHMARK(bmParallelLinearSearch)
+    ->Apply(threadSweep)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
 BENCHMARK_MAIN();
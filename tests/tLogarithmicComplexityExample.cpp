@@ -1,7 +1,20 @@
 #include "BinarySearch.hpp"
+#include "LSMIndex.hpp"
+#include "LearnedSearch.hpp"
+#include "Search.hpp"
 
 #include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
 #include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
 
 using ContainerType = std::vector<int>;
 
@@ -45,7 +58,587 @@ BENCHMARK_DEFINE_F(ContainerFixture, bmBinarySearch)(benchmark::State& aState) {
 
 BENCHMARK_REGISTER_F(ContainerFixture, bmBinarySearch)
     ->RangeMultiplier(10)
-    ->Range(1e3, 1e6)
+    ->Range(1e3, 1e8)
     ->Unit(benchmark::kMicrosecond)
     ->Complexity();
-BENCHMARK_MAIN();
+
+// Random hits, so that every search walks a different path: once the array
+// outgrows the caches (1e7 ints and up) each probe of the sorted layout is a
+// miss, which the Eytzinger and S-tree layouts avoid for the top levels
+template <template <typename> class Layout>
+static void bmBinarySearchLayout(benchmark::State& aState) {
+  auto data = std::make_shared<ContainerType>(aState.range(0));
+  for (int i = 0; i < aState.range(0); ++i) {
+    (*data)[i] = 2 * i;
+  }
+  BinarySearch<ContainerType, Layout> searcher(data);
+
+  static std::default_random_engine engine;
+  auto dist = std::uniform_int_distribution<int>(0, static_cast<int>(aState.range(0)) - 1);
+  std::vector<int> queries(1 << 16);
+  for (auto& query : queries) {
+    query = 2 * dist(engine);
+  }
+
+  size_t next = 0;
+  for (auto _ : aState) {
+    auto result = searcher.rank(queries[next++ & (queries.size() - 1)]);
+    benchmark::DoNotOptimize(result);
+  }
+
+  aState.SetComplexityN(aState.range(0));
+  aState.SetItemsProcessed(aState.iterations());
+}
+
+BENCHMARK_TEMPLATE(bmBinarySearchLayout, SearchLayout::Sorted)
+    ->RangeMultiplier(10)
+    ->Range(1e3, 1e8)
+    ->Unit(benchmark::kNanosecond)
+    ->Complexity(benchmark::oLogN);
+BENCHMARK_TEMPLATE(bmBinarySearchLayout, SearchLayout::Eytzinger)
+    ->RangeMultiplier(10)
+    ->Range(1e3, 1e8)
+    ->Unit(benchmark::kNanosecond)
+    ->Complexity(benchmark::oLogN);
+BENCHMARK_TEMPLATE(bmBinarySearchLayout, SearchLayout::STree)
+    ->RangeMultiplier(10)
+    ->Range(1e3, 1e8)
+    ->Unit(benchmark::kNanosecond)
+    ->Complexity(benchmark::oLogN);
+BENCHMARK_TEMPLATE(bmBinarySearchLayout, SearchLayout::Learned)
+    ->RangeMultiplier(10)
+    ->Range(1e3, 1e8)
+    ->Unit(benchmark::kNanosecond)
+    ->Complexity(benchmark::o1);
+BENCHMARK_TEMPLATE(bmBinarySearchLayout, SearchLayout::Interpolation)
+    ->RangeMultiplier(10)
+    ->Range(1e3, 1e8)
+    ->Unit(benchmark::kNanosecond)
+    ->Complexity(benchmark::o1);
+
+// The same random hits answered 4096 at a time through rankBatch()
+template <template <typename> class Layout>
+static void bmBinarySearchBatch(benchmark::State& aState) {
+  auto data = std::make_shared<ContainerType>(aState.range(0));
+  for (int i = 0; i < aState.range(0); ++i) {
+    (*data)[i] = 2 * i;
+  }
+  BinarySearch<ContainerType, Layout> searcher(data);
+
+  static std::default_random_engine engine;
+  auto dist = std::uniform_int_distribution<int>(0, static_cast<int>(aState.range(0)) - 1);
+  std::vector<int> queries(4096);
+  for (auto& query : queries) {
+    query = 2 * dist(engine);
+  }
+  std::vector<int> ranks(queries.size());
+
+  for (auto _ : aState) {
+    searcher.rankBatch(queries, ranks);
+    benchmark::DoNotOptimize(ranks.data());
+    benchmark::ClobberMemory();
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * queries.size());
+}
+
+BENCHMARK_TEMPLATE(bmBinarySearchBatch, SearchLayout::Sorted)
+    ->RangeMultiplier(10)
+    ->Range(1e3, 1e8)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(bmBinarySearchBatch, SearchLayout::Eytzinger)
+    ->RangeMultiplier(10)
+    ->Range(1e3, 1e8)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(bmBinarySearchBatch, SearchLayout::STree)
+    ->RangeMultiplier(10)
+    ->Range(1e3, 1e8)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(bmBinarySearchBatch, SearchLayout::Learned)
+    ->RangeMultiplier(10)
+    ->Range(1e3, 1e8)
+    ->Unit(benchmark::kMicrosecond);
+
+// Many threads querying one search of 1e6 keys. Every BinarySearch::rank()
+// locks the weak reference, two atomic read-modify-writes on one shared
+// cache line; the view's rank() does none.
+static std::shared_ptr<ContainerType> sharedKeys() {
+  static auto keys = [] {
+    auto data = std::make_shared<ContainerType>(1000000);
+    for (size_t i = 0; i != data->size(); ++i) {
+      (*data)[i] = 2 * static_cast<int>(i);
+    }
+    return data;
+  }();
+  return keys;
+}
+
+template <typename Search>
+static void concurrentQueries(benchmark::State& aState, Search& aSearch) {
+  std::default_random_engine engine(aState.thread_index());
+  auto dist = std::uniform_int_distribution<int>(0, 2 * 1000000);
+  std::vector<int> queries(1 << 12);
+  for (auto& query : queries) {
+    query = dist(engine);
+  }
+
+  size_t next = 0;
+  for (auto _ : aState) {
+    auto result = aSearch.rank(queries[next++ & (queries.size() - 1)]);
+    benchmark::DoNotOptimize(result);
+  }
+  aState.SetItemsProcessed(aState.iterations());
+}
+
+static void bmConcurrentRankShared(benchmark::State& aState) {
+  static BinarySearch<ContainerType> search(sharedKeys());
+  concurrentQueries(aState, search);
+}
+
+static void bmConcurrentRankView(benchmark::State& aState) {
+  static const BinarySearchView<int> search(*sharedKeys());
+  concurrentQueries(aState, search);
+}
+
+static const int MAX_THREADS = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+BENCHMARK(bmConcurrentRankShared)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+BENCHMARK(bmConcurrentRankView)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+
+enum class SortAlgorithm { STD, PARALLEL, RADIX, AUTO };
+
+// Index construction cost: sorting range(0) keys, shuffled or (range(1) = 1)
+// already in order, with each algorithm. AUTO is what BinarySearch uses.
+template <SortAlgorithm Algorithm>
+static void bmSortKeys(benchmark::State& aState) {
+  ContainerType source(aState.range(0));
+  for (size_t i = 0; i != source.size(); ++i) {
+    source[i] = static_cast<int>(i);
+  }
+  if (aState.range(1) == 0) {
+    std::shuffle(source.begin(), source.end(), std::default_random_engine(1));
+  }
+
+  ContainerType keys;
+  for (auto _ : aState) {
+    aState.PauseTiming();
+    keys = source;
+    aState.ResumeTiming();
+
+    switch (Algorithm) {
+      case SortAlgorithm::STD:
+        std::ranges::sort(keys);
+        break;
+      case SortAlgorithm::PARALLEL:
+        SortKeys::parallelSort(keys);
+        break;
+      case SortAlgorithm::RADIX:
+        SortKeys::radixSort(std::span<int>(keys));
+        break;
+      case SortAlgorithm::AUTO:
+        SortKeys::sort(keys);
+        break;
+    }
+    benchmark::DoNotOptimize(keys.data());
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * source.size());
+}
+
+BENCHMARK_TEMPLATE(bmSortKeys, SortAlgorithm::STD)
+    ->ArgNames({"size", "sorted"})
+    ->ArgsProduct({{1000000, 10000000, 100000000}, {0, 1}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bmSortKeys, SortAlgorithm::PARALLEL)
+    ->ArgNames({"size", "sorted"})
+    ->ArgsProduct({{1000000, 10000000, 100000000}, {0, 1}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bmSortKeys, SortAlgorithm::RADIX)
+    ->ArgNames({"size", "sorted"})
+    ->ArgsProduct({{1000000, 10000000, 100000000}, {0, 1}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bmSortKeys, SortAlgorithm::AUTO)
+    ->ArgNames({"size", "sorted"})
+    ->ArgsProduct({{1000000, 10000000, 100000000}, {0, 1}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Whether Layout ranks floating-point keys correctly with infinities at
+// either end, keys far enough apart to overflow their distance, and NaN
+template <template <typename> class Layout, typename V>
+static bool ranksNonFinite() {
+  constexpr V INF = std::numeric_limits<V>::infinity();
+  constexpr V MAX = std::numeric_limits<V>::max();
+  const std::vector<std::vector<V>> keySets = {
+      {-INF, 1, 2, 3}, {1, 2, 3, INF}, {-INF, -INF, 0.5, 2, 1e30, INF, INF}, {-INF, INF}, {INF}, {-MAX, 0, MAX}};
+  const V queries[] = {-INF, INF, std::numeric_limits<V>::quiet_NaN(), -MAX, MAX, 0, 0.5, 1, 2, 3, 4, 1e30};
+  for (const auto& keys : keySets) {
+    BinarySearchView<V, Layout> search(keys);
+    if (!ranksCorrectly<V>(search, keys) || !ranksCorrectly<V>(search, queries)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Keys drawn from an exponential distribution, where one line fits badly:
+// the learned layout adds segments, interpolation widens its window. Each
+// layout is first checked on non-finite floating-point keys.
+template <template <typename> class Layout>
+static void bmSkewedKeys(benchmark::State& aState) {
+  if (!ranksNonFinite<Layout, float>() || !ranksNonFinite<Layout, double>()) {
+    aState.SkipWithError("Layout disagrees with std::lower_bound on non-finite keys");
+    return;
+  }
+  std::default_random_engine engine(1);
+  std::exponential_distribution<double> dist(1.0);
+  auto data = std::make_shared<ContainerType>(aState.range(0));
+  for (auto& key : *data) {
+    // Clamped, as the tail of the distribution exceeds int
+    key = static_cast<int>(std::min(dist(engine) * 1e8, static_cast<double>(std::numeric_limits<int>::max())));
+  }
+  BinarySearch<ContainerType, Layout> searcher(data);
+
+  auto index = std::uniform_int_distribution<size_t>(0, data->size() - 1);
+  std::vector<int> queries(1 << 16);
+  for (auto& query : queries) {
+    query = (*data)[index(engine)];
+  }
+
+  size_t next = 0;
+  for (auto _ : aState) {
+    auto result = searcher.rank(queries[next++ & (queries.size() - 1)]);
+    benchmark::DoNotOptimize(result);
+  }
+  aState.SetItemsProcessed(aState.iterations());
+}
+
+BENCHMARK_TEMPLATE(bmSkewedKeys, SearchLayout::Sorted)->RangeMultiplier(100)->Range(1e4, 1e8);
+BENCHMARK_TEMPLATE(bmSkewedKeys, SearchLayout::Learned)->RangeMultiplier(100)->Range(1e4, 1e8);
+BENCHMARK_TEMPLATE(bmSkewedKeys, SearchLayout::Interpolation)->RangeMultiplier(100)->Range(1e4, 1e8);
+
+// A sorted vector updated in place, the alternative to LSMIndex that keeps
+// one array: O(n) element moves per update
+class SortedVectorIndex {
+public:
+  explicit SortedVectorIndex(const ContainerType& aKeys) : fKeys(aKeys) {
+    std::ranges::sort(fKeys);
+  }
+  void insert(int aKey) {
+    fKeys.insert(std::ranges::upper_bound(fKeys, aKey), aKey);
+  }
+  bool erase(int aKey) {
+    auto it = std::ranges::lower_bound(fKeys, aKey);
+    if (it == fKeys.end() || *it != aKey) {
+      return false;
+    }
+    fKeys.erase(it);
+    return true;
+  }
+  size_t lowerBound(int aKey) const {
+    return std::ranges::lower_bound(fKeys, aKey) - fKeys.begin();
+  }
+
+private:
+  ContainerType fKeys;
+};
+
+// range(0) keys in [0, 2 * range(0)) under a stream of operations of which
+// range(1) percent are writes (half inserts, half erases) and the rest
+// lowerBound() queries
+template <typename Index>
+static void bmUpdatableIndex(benchmark::State& aState) {
+  std::default_random_engine engine(1);
+  auto keyDist = std::uniform_int_distribution<int>(0, 2 * static_cast<int>(aState.range(0)));
+  ContainerType keys(aState.range(0));
+  for (auto& key : keys) {
+    key = keyDist(engine);
+  }
+  Index index(keys);
+
+  std::vector<std::pair<int, int>> operations(1 << 16); // Kind, key
+  auto percent = std::uniform_int_distribution<int>(0, 99);
+  for (auto& [kind, key] : operations) {
+    int draw = percent(engine);
+    kind = draw < aState.range(1) ? draw % 2 : 2;
+    key = keyDist(engine);
+  }
+
+  size_t next = 0;
+  for (auto _ : aState) {
+    auto [kind, key] = operations[next++ & (operations.size() - 1)];
+    if (kind == 0) {
+      index.insert(key);
+    } else if (kind == 1) {
+      benchmark::DoNotOptimize(index.erase(key));
+    } else {
+      benchmark::DoNotOptimize(index.lowerBound(key));
+    }
+  }
+  aState.SetItemsProcessed(aState.iterations());
+}
+
+BENCHMARK_TEMPLATE(bmUpdatableIndex, LSMIndex<int>)
+    ->ArgNames({"size", "writes"})
+    ->ArgsProduct({{10000, 1000000, 10000000}, {10, 50}})
+    ->Unit(benchmark::kNanosecond);
+BENCHMARK_TEMPLATE(bmUpdatableIndex, SortedVectorIndex)
+    ->ArgNames({"size", "writes"})
+    ->ArgsProduct({{10000, 1000000, 10000000}, {10, 50}})
+    ->Unit(benchmark::kNanosecond);
+
+static constexpr SearchStrategy STRATEGIES[] = {SearchStrategy::LINEAR, SearchStrategy::BINARY,
+                                                SearchStrategy::EYTZINGER, SearchStrategy::STREE};
+
+// Whether aSearch (a Search or a BinarySearchView) finds each of aQueries
+// exactly when it is one of the keys. A NaN query is never one of them.
+template <typename V, typename Searcher>
+static bool ranksCorrectly(const Searcher& aSearch, std::span<const V> aQueries) {
+  auto sorted = aSearch.sorted();
+  for (const V& query : aQueries) {
+    int rank = aSearch.rank(query);
+    auto lower = std::ranges::lower_bound(sorted, query);
+    bool present = lower != sorted.end() && *lower == query;
+    if (rank < 0 ? present : sorted[rank] != query) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Random hits on aSize keys of type V through Search, with aStrategy or, if
+// it is null, the one the thresholds choose. Before timing, the hits, a few
+// misses and, for floating point, infinite keys and a NaN query are checked
+// against std::lower_bound.
+template <typename V>
+static void searchHits(benchmark::State& aState, size_t aSize, const SearchStrategy* aStrategy) {
+  std::vector<V> keys(aSize);
+  for (size_t i = 0; i != aSize; ++i) {
+    keys[i] = static_cast<V>(2 * i);
+  }
+  auto search = aStrategy ? Search<V>(keys, *aStrategy) : Search<V>(keys);
+  aState.SetLabel(strategyName(search.strategy()));
+
+  std::default_random_engine engine;
+  auto dist = std::uniform_int_distribution<size_t>(0, aSize - 1);
+  std::vector<V> queries(1 << 12);
+  for (auto& query : queries) {
+    query = keys[dist(engine)];
+  }
+
+  const V misses[] = {static_cast<V>(-1), static_cast<V>(1), static_cast<V>(2 * aSize)};
+  bool correct = ranksCorrectly<V>(search, queries) && ranksCorrectly<V>(search, misses);
+  if constexpr (std::is_floating_point_v<V>) {
+    // Infinity must not be mistaken for the S-tree's padding
+    const V extremes[] = {std::numeric_limits<V>::infinity(), -std::numeric_limits<V>::infinity(),
+                          std::numeric_limits<V>::max(), std::numeric_limits<V>::lowest(),
+                          std::numeric_limits<V>::quiet_NaN()};
+    auto infinite = keys;
+    infinite.push_back(extremes[0]);
+    infinite.push_back(extremes[1]);
+    auto withInfinity = aStrategy ? Search<V>(infinite, *aStrategy) : Search<V>(infinite);
+    correct = correct && ranksCorrectly<V>(withInfinity, extremes);
+  }
+  if (!correct) {
+    aState.SkipWithError("Search disagrees with std::lower_bound");
+    return;
+  }
+
+  size_t next = 0;
+  for (auto _ : aState) {
+    auto result = search.rank(queries[next++ & (queries.size() - 1)]);
+    benchmark::DoNotOptimize(result);
+  }
+  aState.SetItemsProcessed(aState.iterations());
+}
+
+// Search<V> with each strategy forced (0 to 3) and with the one its
+// thresholds choose (-1), which should match the fastest of the others
+template <typename V>
+static void bmSearchStrategy(benchmark::State& aState) {
+  auto strategy = static_cast<SearchStrategy>(aState.range(1));
+  searchHits<V>(aState, aState.range(0), aState.range(1) < 0 ? nullptr : &strategy);
+}
+
+BENCHMARK_TEMPLATE(bmSearchStrategy, int)
+    ->ArgNames({"size", "strategy"})
+    ->ArgsProduct({{16, 256, 4096, 65536, 1 << 20}, {-1, 0, 1, 2, 3}})
+    ->Unit(benchmark::kNanosecond);
+BENCHMARK_TEMPLATE(bmSearchStrategy, float)
+    ->ArgNames({"size", "strategy"})
+    ->ArgsProduct({{16, 256, 4096, 65536, 1 << 20}, {-1, 0, 1, 2, 3}})
+    ->Unit(benchmark::kNanosecond);
+
+// Calibration of SearchThresholds: every strategy timed for every key type
+// at each size of the grid, registered only for --calibrate=<path>
+namespace Calibration {
+  constexpr size_t MIN_SIZE = 1;
+  constexpr size_t MAX_SIZE = 1 << 20;
+  // Past this the scan is far behind, and timing it would dominate the run
+  constexpr size_t MAX_LINEAR_SIZE = 1 << 14;
+
+  std::vector<size_t> sizes() {
+    std::vector<size_t> result;
+    for (size_t size = MIN_SIZE; size <= MAX_SIZE; size *= 2) {
+      result.push_back(size);
+    }
+    return result;
+  }
+
+  std::string benchmarkName(const char* aType, SearchStrategy aStrategy, size_t aSize) {
+    return std::string("calibrate/") + aType + "/" + strategyName(aStrategy) + "/" + std::to_string(aSize);
+  }
+
+  template <typename V>
+  void registerType(const char* aType) {
+    for (SearchStrategy strategy : STRATEGIES) {
+      for (size_t size : sizes()) {
+        if (strategy == SearchStrategy::LINEAR && size > MAX_LINEAR_SIZE) {
+          continue;
+        }
+        benchmark::RegisterBenchmark(benchmarkName(aType, strategy, size).c_str(),
+                                     [strategy, size](benchmark::State& aState) {
+                                       searchHits<V>(aState, size, &strategy);
+                                     })
+            ->MinTime(0.1)
+            ->Unit(benchmark::kNanosecond);
+      }
+    }
+  }
+
+  // Prints the runs as usual and keeps the lowest CPU time of each benchmark
+  class Reporter : public benchmark::ConsoleReporter {
+  public:
+    void ReportRuns(const std::vector<Run>& aRuns) override {
+      for (const auto& run : aRuns) {
+        if (run.run_type != Run::RT_Iteration) {
+          continue;
+        }
+        auto [it, inserted] = fNanoseconds.emplace(run.run_name.function_name, run.GetAdjustedCPUTime());
+        if (!inserted) {
+          it->second = std::min(it->second, run.GetAdjustedCPUTime());
+        }
+      }
+      ConsoleReporter::ReportRuns(aRuns);
+    }
+
+    double nanoseconds(const std::string& aName) const {
+      auto it = fNanoseconds.find(aName);
+      return it == fNanoseconds.end() ? std::numeric_limits<double>::infinity() : it->second;
+    }
+
+  private:
+    std::map<std::string, double> fNanoseconds;
+  };
+
+  // The crossovers, as indices in the grid, that minimize the sum over the
+  // grid of each size's time relative to its fastest strategy. Crossovers
+  // fall on grid sizes, so they are exact to a factor of two.
+  std::string crossovers(const char* aType, const Reporter& aReporter) {
+    auto grid = sizes();
+    size_t count = grid.size();
+    std::vector<std::vector<double>> relative(std::size(STRATEGIES), std::vector<double>(count));
+    for (size_t i = 0; i != count; ++i) {
+      double best = std::numeric_limits<double>::infinity();
+      for (SearchStrategy strategy : STRATEGIES) {
+        best = std::min(best, aReporter.nanoseconds(benchmarkName(aType, strategy, grid[i])));
+      }
+      for (SearchStrategy strategy : STRATEGIES) {
+        relative[static_cast<size_t>(strategy)][i] =
+            aReporter.nanoseconds(benchmarkName(aType, strategy, grid[i])) / best;
+      }
+    }
+
+    double bestCost = std::numeric_limits<double>::infinity();
+    size_t bounds[3] = {0, 0, 0};
+    for (size_t binary = 0; binary <= count; ++binary) {
+      for (size_t eytzinger = binary; eytzinger <= count; ++eytzinger) {
+        for (size_t stree = eytzinger; stree <= count; ++stree) {
+          double cost = 0;
+          for (size_t i = 0; i != count; ++i) {
+            size_t strategy = i < binary ? 0 : i < eytzinger ? 1 : i < stree ? 2 : 3;
+            cost += relative[strategy][i];
+          }
+          if (cost < bestCost) {
+            bestCost = cost;
+            bounds[0] = binary;
+            bounds[1] = eytzinger;
+            bounds[2] = stree;
+          }
+        }
+      }
+    }
+
+    std::string result;
+    for (size_t bound : bounds) {
+      result += result.empty() ? "{" : ", ";
+      result += bound == count ? "NEVER" : std::to_string(grid[bound]);
+    }
+    return result + "}";
+  }
+} // namespace Calibration
+
+// The usual benchmarks, or with --calibrate=<path> only the calibration,
+// whose crossovers are written to <path> for -DMW_SEARCH_THRESHOLDS
+int main(int argc, char** argv) {
+  const std::string CALIBRATE = "--calibrate=";
+  std::string output;
+  std::string filter = "--benchmark_filter=^calibrate/";
+  std::vector<char*> args;
+  for (int i = 0; i != argc; ++i) {
+    if (std::string(argv[i]).starts_with(CALIBRATE)) {
+      output = std::string(argv[i]).substr(CALIBRATE.size());
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+  if (!output.empty()) {
+    args.push_back(filter.data());
+  }
+
+  const std::pair<const char*, void (*)(const char*)> TYPES[] = {
+      {"int32_t", Calibration::registerType<int32_t>},
+      {"int64_t", Calibration::registerType<int64_t>},
+      {"float", Calibration::registerType<float>},
+      {"double", Calibration::registerType<double>}};
+  if (!output.empty()) {
+    for (auto [type, registerType] : TYPES) {
+      registerType(type);
+    }
+  }
+
+  int count = static_cast<int>(args.size());
+  benchmark::Initialize(&count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+    return 1;
+  }
+  if (output.empty()) {
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+  }
+
+  Calibration::Reporter reporter;
+  benchmark::RunSpecifiedBenchmarks(&reporter);
+  benchmark::Shutdown();
+
+  std::ofstream file(output);
+  file << "// Search crossovers measured by tLogarithmicComplexityExample --calibrate,\n"
+       << "// included by SearchThresholds.hpp when configured with -DMW_SEARCH_THRESHOLDS\n"
+       << "namespace SearchThresholds {\n";
+  for (auto [type, registerType] : TYPES) {
+    std::string crossovers = Calibration::crossovers(type, reporter);
+    std::cout << type << ": " << crossovers << "\n";
+    file << (type == TYPES[0].first ? "" : "\n") << "  template <>\n"
+         << "  inline constexpr Crossovers CROSSOVERS<" << type << "> = " << crossovers << ";\n";
+  }
+  file << "} // namespace SearchThresholds\n";
+  if (!file) {
+    std::cerr << "Cannot write " << output << "\n";
+    return 1;
+  }
+  return 0;
+}
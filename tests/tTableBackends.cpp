@@ -0,0 +1,371 @@
+#include "VNTable.hpp"
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One benchmark driver for every value-number table backend, under
+// configurable workloads.
+//
+// A backend maps entities (ints) to value numbers and answers three
+// operations: the value number of an entity (a read), the entities of a
+// value number (a congruence query), and assigning an entity a value number
+// (a write, insertOrReplace()); insert() adds an entity known to be new, to
+// populate the table. Backends without an index for one side answer its queries by a
+// scan, which is what choosing that container costs.
+//
+// Each run populates the table, then replays a pre-generated stream of
+// operations drawn from the workload, so that the generators stay out of the
+// measured loop. Run with --workload=<spec> to benchmark every backend under
+// a workload of your own instead of the built-in ones, e.g.
+//
+//   tTableBackends --workload=size=1000000,classes=5000,key_skew=0.99,class_skew=1.1,read=80,write=10,hit=95
+//
+// (see Workload for the keys and their defaults).
+
+using ValueNumber = uint64_t;
+
+// Backend over VNTable or any table with its interface: an index on each
+// side, so every operation is a lookup
+template <typename Table>
+class VNTableBackend {
+public:
+  std::optional<ValueNumber> value(int aEntity) const {
+    return fTable.value(aEntity);
+  }
+
+  size_t congruent(ValueNumber aValue) const {
+    size_t count = 0;
+    for (const auto& [valueNumber, entity] : boost::make_iterator_range(fTable.congruence(aValue))) {
+      benchmark::DoNotOptimize(entity);
+      ++count;
+    }
+    return count;
+  }
+
+  void insertOrReplace(int aEntity, ValueNumber aValue) {
+    fTable.insertOrReplace(aEntity, aValue);
+  }
+
+  void insert(int aEntity, ValueNumber aValue) {
+    fTable.insertOrReplace(aEntity, aValue);
+  }
+
+private:
+  Table fTable;
+};
+
+// std::unordered_map from entity to value number: congruence queries scan
+// the whole table
+class UnorderedMapBackend {
+public:
+  std::optional<ValueNumber> value(int aEntity) const {
+    auto it = fTable.find(aEntity);
+    return it == fTable.end() ? std::nullopt : std::optional<ValueNumber>(it->second);
+  }
+
+  size_t congruent(ValueNumber aValue) const {
+    size_t count = 0;
+    for (const auto& [entity, valueNumber] : fTable) {
+      if (valueNumber == aValue) {
+        benchmark::DoNotOptimize(entity);
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  void insertOrReplace(int aEntity, ValueNumber aValue) {
+    fTable.insert_or_assign(aEntity, aValue);
+  }
+
+  void insert(int aEntity, ValueNumber aValue) {
+    fTable.insert({aEntity, aValue});
+  }
+
+private:
+  std::unordered_map<int, ValueNumber> fTable;
+};
+
+// std::unordered_multimap from value number to entity: reads and writes
+// scan the whole table for the entity
+class UnorderedMultiMapBackend {
+public:
+  std::optional<ValueNumber> value(int aEntity) const {
+    auto it = std::ranges::find_if(fTable, [aEntity](const auto& aEntry) { return aEntry.second == aEntity; });
+    return it == fTable.end() ? std::nullopt : std::optional<ValueNumber>(it->first);
+  }
+
+  size_t congruent(ValueNumber aValue) const {
+    size_t count = 0;
+    for (const auto& [valueNumber, entity] : boost::make_iterator_range(fTable.equal_range(aValue))) {
+      benchmark::DoNotOptimize(entity);
+      ++count;
+    }
+    return count;
+  }
+
+  void insertOrReplace(int aEntity, ValueNumber aValue) {
+    auto it = std::ranges::find_if(fTable, [aEntity](const auto& aEntry) { return aEntry.second == aEntity; });
+    if (it != fTable.end()) {
+      fTable.erase(it);
+    }
+    insert(aEntity, aValue);
+  }
+
+  void insert(int aEntity, ValueNumber aValue) {
+    fTable.insert({aValue, aEntity});
+  }
+
+private:
+  std::unordered_multimap<ValueNumber, int> fTable;
+};
+
+// Ranks 0 to aCount - 1 drawn with probability proportional to
+// 1 / (rank + 1)^aSkew: 0 is uniform, around 1 is the usual Zipf law, and
+// larger skews concentrate on the first ranks
+class ZipfDistribution {
+public:
+  ZipfDistribution(size_t aCount, double aSkew) : fCumulative(aCount) {
+    double total = 0;
+    for (size_t rank = 0; rank != aCount; ++rank) {
+      total += 1 / std::pow(static_cast<double>(rank + 1), aSkew);
+      fCumulative[rank] = total;
+    }
+  }
+
+  template <typename Engine>
+  size_t operator()(Engine& aEngine) {
+    double weight = std::uniform_real_distribution<double>(0, fCumulative.back())(aEngine);
+    size_t rank = std::ranges::upper_bound(fCumulative, weight) - fCumulative.begin();
+    return std::min(rank, fCumulative.size() - 1);
+  }
+
+private:
+  std::vector<double> fCumulative;
+};
+
+// Table contents and operation mix. Percentages are of all operations;
+// what is left after reads and writes is congruence queries.
+struct Workload {
+  std::string name;
+  int64_t size = 100000;   // Entities in the table
+  int64_t classes = 200;   // Value numbers they are spread over
+  double keySkew = 0;      // Zipf skew of the entities operations touch
+  double classSkew = 0;    // Zipf skew of class sizes, and of the classes
+                           // congruence queries and writes pick
+  int64_t readPercent = 100;
+  int64_t writePercent = 0;
+  int64_t hitPercent = 100; // Reads of entities in the table; the rest miss
+};
+
+enum class Operation { READ, WRITE, CONGRUENCE };
+
+struct Request {
+  Operation operation;
+  int entity;
+  ValueNumber value;
+};
+
+// The populated table's entities in rank order (most touched first under
+// key skew) and the size of each class
+struct Population {
+  std::vector<int> entities;
+  std::vector<size_t> classSizes;
+};
+
+template <typename Backend>
+static Population populate(Backend& aBackend, const Workload& aWorkload, std::default_random_engine& aEngine) {
+  Population population;
+  population.entities.resize(aWorkload.size);
+  std::iota(population.entities.begin(), population.entities.end(), 0);
+  std::ranges::shuffle(population.entities, aEngine);
+  population.classSizes.resize(aWorkload.classes);
+
+  ZipfDistribution classes(aWorkload.classes, aWorkload.classSkew);
+  for (int entity = 0; entity != aWorkload.size; ++entity) {
+    ValueNumber value = classes(aEngine);
+    aBackend.insert(entity, value);
+    ++population.classSizes[value];
+  }
+  return population;
+}
+
+// Writes reassign entities of the table, so its size stays the same
+static std::vector<Request> requests(const Workload& aWorkload, const Population& aPopulation,
+                                     std::default_random_engine& aEngine) {
+  ZipfDistribution entities(aWorkload.size, aWorkload.keySkew);
+  ZipfDistribution classes(aWorkload.classes, aWorkload.classSkew);
+  std::uniform_int_distribution<int64_t> percent(0, 99);
+
+  std::vector<Request> result(1 << 16);
+  for (auto& request : result) {
+    int64_t draw = percent(aEngine);
+    int entity = aPopulation.entities[entities(aEngine)];
+    if (draw < aWorkload.readPercent) {
+      // Entities past the table's miss
+      bool hit = percent(aEngine) < aWorkload.hitPercent;
+      request = {Operation::READ, hit ? entity : static_cast<int>(aWorkload.size) + entity, 0};
+    } else if (draw < aWorkload.readPercent + aWorkload.writePercent) {
+      request = {Operation::WRITE, entity, classes(aEngine)};
+    } else {
+      request = {Operation::CONGRUENCE, 0, classes(aEngine)};
+    }
+  }
+  return result;
+}
+
+template <typename Backend>
+static void bmTableBackend(benchmark::State& aState, const Workload& aWorkload) {
+  std::default_random_engine engine(1);
+  Backend backend;
+  auto population = populate(backend, aWorkload, engine);
+  auto stream = requests(aWorkload, population, engine);
+
+  size_t next = 0;
+  for (auto _ : aState) {
+    const auto& request = stream[next++ & (stream.size() - 1)];
+    switch (request.operation) {
+      case Operation::READ:
+        benchmark::DoNotOptimize(backend.value(request.entity));
+        break;
+      case Operation::WRITE:
+        backend.insertOrReplace(request.entity, request.value);
+        break;
+      case Operation::CONGRUENCE:
+        benchmark::DoNotOptimize(backend.congruent(request.value));
+        break;
+    }
+  }
+
+  aState.SetItemsProcessed(aState.iterations());
+  // Share of the entities in the largest class when the table was filled
+  aState.counters["largest_class"] =
+      static_cast<double>(std::ranges::max(population.classSizes)) / static_cast<double>(aWorkload.size);
+}
+
+// Every backend under aWorkload
+static void registerWorkload(const Workload& aWorkload) {
+  auto add = [&](const char* aBackend, void (*aBenchmark)(benchmark::State&, const Workload&)) {
+    std::string name = std::string(aBackend) + "/" + aWorkload.name + "/size:" + std::to_string(aWorkload.size);
+    benchmark::RegisterBenchmark(name.c_str(), aBenchmark, aWorkload)->Unit(benchmark::kNanosecond);
+  };
+  add("VNTable", bmTableBackend<VNTableBackend<VNTable<int>>>);
+  add("unordered_map", bmTableBackend<UnorderedMapBackend>);
+  add("unordered_multimap", bmTableBackend<UnorderedMultiMapBackend>);
+}
+
+// The built-in workloads: the uniform 200-class reads, writes and
+// congruence queries the per-container benchmarks used to measure, then
+// skewed mixes closer to production, where a few classes hold most entities
+static std::vector<Workload> defaultWorkloads() {
+  std::vector<Workload> result;
+  for (int64_t size : {1000, 10000, 100000}) {
+    result.push_back({.name = "uniform_read", .size = size});
+    result.push_back({.name = "uniform_write", .size = size, .readPercent = 0, .writePercent = 100});
+    result.push_back({.name = "uniform_congruence", .size = size, .readPercent = 0});
+  }
+  for (int64_t size : {10000, 100000}) {
+    Workload skewed{.size = size, .classes = 5000, .keySkew = 0.99, .classSkew = 1.1, .hitPercent = 90};
+    skewed.name = "skewed_read_mostly";
+    skewed.readPercent = 90;
+    skewed.writePercent = 9;
+    result.push_back(skewed);
+    skewed.name = "skewed_mixed";
+    skewed.readPercent = 50;
+    skewed.writePercent = 40;
+    result.push_back(skewed);
+  }
+  return result;
+}
+
+// A workload from comma-separated key=value pairs over the fields of
+// Workload: size, classes, key_skew, class_skew, read, write, hit
+static std::optional<Workload> parseWorkload(const std::string& aSpec) {
+  Workload workload;
+  size_t begin = 0;
+  while (begin < aSpec.size()) {
+    size_t end = std::min(aSpec.find(',', begin), aSpec.size());
+    std::string field = aSpec.substr(begin, end - begin);
+    begin = end + 1;
+    size_t equals = field.find('=');
+    if (equals == std::string::npos) {
+      return std::nullopt;
+    }
+    std::string key = field.substr(0, equals);
+    double value = 0;
+    try {
+      value = std::stod(field.substr(equals + 1));
+    } catch (const std::exception&) {
+      return std::nullopt;
+    }
+    if (key == "size") {
+      workload.size = static_cast<int64_t>(value);
+    } else if (key == "classes") {
+      workload.classes = static_cast<int64_t>(value);
+    } else if (key == "key_skew") {
+      workload.keySkew = value;
+    } else if (key == "class_skew") {
+      workload.classSkew = value;
+    } else if (key == "read") {
+      workload.readPercent = static_cast<int64_t>(value);
+    } else if (key == "write") {
+      workload.writePercent = static_cast<int64_t>(value);
+    } else if (key == "hit") {
+      workload.hitPercent = static_cast<int64_t>(value);
+    } else {
+      return std::nullopt;
+    }
+  }
+  if (workload.size < 1 || workload.classes < 1 || workload.readPercent < 0 || workload.writePercent < 0 ||
+      workload.readPercent + workload.writePercent > 100 || workload.hitPercent < 0 || workload.hitPercent > 100) {
+    return std::nullopt;
+  }
+  return workload;
+}
+
+int main(int argc, char** argv) {
+  const std::string WORKLOAD = "--workload=";
+  std::vector<Workload> workloads;
+  std::vector<char*> args;
+  for (int i = 0; i != argc; ++i) {
+    std::string arg = argv[i];
+    if (!arg.starts_with(WORKLOAD)) {
+      args.push_back(argv[i]);
+      continue;
+    }
+    auto workload = parseWorkload(arg.substr(WORKLOAD.size()));
+    if (!workload) {
+      std::cerr << "Invalid workload: " << arg << "\n";
+      return 1;
+    }
+    workload->name = "custom" + std::to_string(workloads.size() + 1);
+    workloads.push_back(*workload);
+  }
+  if (workloads.empty()) {
+    workloads = defaultWorkloads();
+  }
+  for (const auto& workload : workloads) {
+    registerWorkload(workload);
+  }
+
+  int count = static_cast<int>(args.size());
+  benchmark::Initialize(&count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}